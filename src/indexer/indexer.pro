@@ -0,0 +1,25 @@
+TEMPLATE = app
+
+TARGET = dashboard-indexer
+
+QT = core
+CONFIG += console
+CONFIG -= app_bundle
+
+dashboard_sdt: DEFINES += DASHBOARD_SDT
+
+INCLUDEPATH += ../qml
+
+HEADERS += \
+    ../qml/widgetmanifest.h \
+    ../qml/widgetindex.h \
+    ../qml/widgettrace.h
+
+SOURCES += \
+    main.cpp \
+    ../qml/widgetmanifest.cpp \
+    ../qml/widgetindex.cpp \
+    ../qml/widgettrace.cpp
+
+target.path = /usr/bin
+INSTALLS += target
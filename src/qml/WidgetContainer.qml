@@ -37,6 +37,26 @@ Item {
     property Item moveParent
     property int index
     property WidgetListModel widgetListModel
+    property Widget contextInfo
+    property Component placeholder
+    readonly property bool loading: contextInfo != null && contextInfo.status == Widget.Loading
+    // When virtualized, the widget only exists while the container is
+    // inside the viewport. viewportVisible and viewportDistance are set by
+    // a WidgetLayoutIndex that follows the viewport for all the containers.
+    property bool virtualized: false
+    property bool viewportVisible: !virtualized
+    readonly property bool inViewport: !virtualized || viewportVisible
+    // Distance to the visible part of the viewport, 0 when visible. Widgets
+    // are created in increasing distance order.
+    property real viewportDistance: 0
+    property real releasedWidth: 0
+    property real releasedHeight: 0
+    // Set to false when input is handled by a WidgetInputController, that
+    // calls startMove, moveTo and finishMove instead.
+    property bool interactive: true
+    property bool moving: false
+    property real pointerX: 0
+    property real pointerY: 0
     signal moveStarted()
     signal moveFinished()
     signal moved(real x, real y)
@@ -45,77 +65,143 @@ Item {
     signal pressAndHold()
     property int minimumWidth: 0
     property int minimumHeight: 0
-    implicitWidth: Math.max(widgetContainer.childrenRect.width, minimumWidth)
-    implicitHeight: Math.max(widgetContainer.childrenRect.height, minimumHeight)
+    implicitWidth: Math.max(widgetContainer.childrenRect.width, minimumWidth, releasedWidth)
+    implicitHeight: Math.max(widgetContainer.childrenRect.height, minimumHeight, releasedHeight)
 
-    Item {
-        id: widgetContainer
-        function move() {
-            if (mouseArea.isMoving) {
-                container.moved(mouseArea.mouseX, mouseArea.mouseY)
-            }
+    function createWidget() {
+        if (widgetListModel == null) {
+            console.warn("Cannot create widget: no model set.")
+            return
         }
+        container.widgetListModel.createWidget(container.index, widgetContainer, container.viewportDistance)
+        widgetContainer.requested = true
+        container.releasedWidth = 0
+        container.releasedHeight = 0
+    }
 
-        width: container.width
-        height: container.height
-        onXChanged: widgetContainer.move()
-        onYChanged: widgetContainer.move()
+    function releaseWidget() {
+        if (widgetListModel == null || container.moving) {
+            return
+        }
+        // Keep the size, so that the layout does not move while unloaded
+        container.releasedWidth = widgetContainer.childrenRect.width
+        container.releasedHeight = widgetContainer.childrenRect.height
+        container.widgetListModel.releaseWidget(container.index)
+    }
 
-        Component.onCompleted: {
-            if (widgetListModel == null) {
-                console.warn("Cannot create widget: no model set.")
-                return
-            }
-            container.widgetListModel.createWidget(container.index, widgetContainer)
+    // x and y are the pointer position, in the container coordinates
+    function startMove(x, y) {
+        if (container.moveParent == null) {
+            console.warn("Cannot move widget: no moveParent set. ")
+            return
         }
+
+        container.pointerX = x
+        container.pointerY = y
+        widgetContainer.grabX = x
+        widgetContainer.grabY = y
+        container.reparent(container.moveParent)
+        widgetContainer.z = 1000
+        container.moving = true
+        container.moveStarted()
     }
 
-    MouseArea {
-        id: mouseArea
-        z: 1000
-        anchors.fill: parent
-        property Item previousParent
-        property bool isMoving: false
+    function moveTo(x, y) {
+        if (!container.moving) {
+            return
+        }
 
-        function startMove() {
-            if (container.moveParent == null) {
-                console.warn("Cannot move widget: no moveParent set. ")
-                return
-            }
+        // The point that was grabbed stays under the pointer
+        container.pointerX = x
+        container.pointerY = y
+        var position = container.mapToItem(container.moveParent, x - widgetContainer.grabX,
+                                           y - widgetContainer.grabY)
+        widgetContainer.x = position.x - widgetContainer.width / 2 * (1 - widgetContainer.scale)
+        widgetContainer.y = position.y - widgetContainer.height / 2 * (1 - widgetContainer.scale)
+        // Once per call, so once per frame when driven by the controller
+        container.moved(x, y)
+    }
 
-            reparent(container.moveParent)
-            widgetContainer.z = 1000
-            drag.target = widgetContainer
-            mouseArea.isMoving = true
-            container.moveStarted()
+    function finishMove() {
+        if (!container.moving) {
+            return
         }
 
+        container.reparent(container)
+        widgetContainer.z = 0
+        moveBackAnimation.start()
+        container.moving = false
+        container.moveFinished()
+    }
 
-        function finishMove() {
-            if (container.moveParent == null) {
-                return
-            }
+    function reparent(newParent) {
+        var newPos = widgetContainer.mapToItem(newParent, 0, 0)
+        widgetContainer.parent = newParent
+        widgetContainer.x = newPos.x - widgetContainer.width / 2 * (1 - widgetContainer.scale)
+        widgetContainer.y = newPos.y - widgetContainer.height / 2 * (1 - widgetContainer.scale)
+    }
 
-            reparent(container)
-            widgetContainer.z = 0
-            moveBackAnimation.start()
-            drag.target = null
-            mouseArea.isMoving = false
-            container.moveFinished()
+    onInViewportChanged: {
+        if (container.contextInfo == null) {
+            return
         }
 
-        function reparent(newParent) {
-            var newPos = widgetContainer.mapToItem(newParent, 0, 0)
-            widgetContainer.parent = newParent
-            widgetContainer.x = newPos.x - widgetContainer.width / 2 * (1 - widgetContainer.scale)
-            widgetContainer.y = newPos.y - widgetContainer.height / 2 * (1 - widgetContainer.scale)
+        if (container.inViewport && container.contextInfo.status == Widget.Null) {
+            container.createWidget()
+        } else if (!container.inViewport && container.contextInfo.status != Widget.Null) {
+            container.releaseWidget()
+        }
+    }
+    onViewportDistanceChanged: {
+        if (container.loading && widgetListModel != null) {
+            container.widgetListModel.setPriority(container.index, container.viewportDistance)
         }
+    }
+
+    Item {
+        id: widgetContainer
+        property real grabX: 0
+        property real grabY: 0
+        property bool requested: false
+
+        width: container.width
+        height: container.height
+
+        Component.onCompleted: {
+            // Might already be requested, if the index was faster
+            if (container.inViewport && !widgetContainer.requested) {
+                container.createWidget()
+            }
+        }
+        Component.onDestruction: {
+            if (container.loading && widgetListModel != null) {
+                container.widgetListModel.cancelCreation(container.index)
+            }
+        }
+    }
+
+    Loader {
+        id: placeholderLoader
+        anchors.fill: parent
+        active: container.placeholder != null && container.contextInfo != null
+                && container.contextInfo.status != Widget.Ready
+        sourceComponent: container.placeholder
+    }
 
-        onPressed: startMove()
-        onReleased: finishMove()
-        onClicked: container.clicked()
-        onDoubleClicked: container.doubleClicked()
-        onPressAndHold: container.pressAndHold()
+    Loader {
+        id: mouseAreaLoader
+        z: 1000
+        anchors.fill: parent
+        active: container.interactive
+        sourceComponent: MouseArea {
+            onPressed: container.startMove(mouse.x, mouse.y)
+            onPositionChanged: container.moveTo(mouse.x, mouse.y)
+            onReleased: container.finishMove()
+            onCanceled: container.finishMove()
+            onClicked: container.clicked()
+            onDoubleClicked: container.doubleClicked()
+            onPressAndHold: container.pressAndHold()
+        }
     }
 
     NumberAnimation {
@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "dashboardservice.h"
+#include <QtQml/QQmlEngine>
+#include "widgetcomponentcache.h"
+#include "widgetfactory.h"
+#include "widgetmanifestregistry.h"
+#include "widgettrace.h"
+
+class DashboardServicePrivate
+{
+public:
+    explicit DashboardServicePrivate(DashboardService *q);
+    QQmlEngine *engine;
+    WidgetComponentCache *componentCache;
+    WidgetManifestRegistry *manifestRegistry;
+    WidgetFactory *factory;
+    WidgetUpdateCoalescer *updates;
+    WidgetTeardownScheduler *teardown;
+    // Trace started by this service, tracing is shared by all the engines
+    QString traceFile;
+protected:
+    DashboardService * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(DashboardService)
+};
+
+DashboardServicePrivate::DashboardServicePrivate(DashboardService *q)
+    : engine(0), componentCache(0), manifestRegistry(0), factory(0), updates(0), teardown(0), q_ptr(q)
+{
+}
+
+DashboardService::DashboardService(QQmlEngine *engine)
+    : QObject(engine), d_ptr(new DashboardServicePrivate(this))
+{
+    Q_D(DashboardService);
+    d->engine = engine;
+    d->componentCache = new WidgetComponentCache(engine, this);
+    d->manifestRegistry = new WidgetManifestRegistry(this);
+    d->teardown = new WidgetTeardownScheduler(this);
+    d->factory = new WidgetFactory(engine, d->componentCache, d->teardown, this);
+    d->updates = new WidgetUpdateCoalescer(this);
+    connect(d->factory, &WidgetFactory::pendingCountChanged, this, &DashboardService::pendingCountChanged);
+    connect(d->factory, &WidgetFactory::visiblePendingCountChanged,
+            this, &DashboardService::visiblePendingCountChanged);
+    connect(d->factory, &WidgetFactory::pooledCountChanged, this, &DashboardService::pooledCountChanged);
+
+    // Allows to trace the startup, before QML gets a chance to set the file
+    QString traceFile = QString::fromLocal8Bit(qgetenv("DASHBOARD_TRACE_FILE"));
+    if (!traceFile.isEmpty() && !WidgetTrace::isEnabled()) {
+        WidgetTrace::start(traceFile);
+        d->traceFile = traceFile;
+    }
+}
+
+DashboardService::~DashboardService()
+{
+    Q_D(DashboardService);
+    // Written when the engine goes away, usually at exit. Traces started
+    // through another engine are left to that engine.
+    if (!d->traceFile.isEmpty() && WidgetTrace::fileName() == d->traceFile) {
+        WidgetTrace::stop();
+    }
+}
+
+DashboardService * DashboardService::instance(QQmlEngine *engine)
+{
+    if (!engine) {
+        return 0;
+    }
+
+    // One service per engine, owned by the engine itself. It is created
+    // by the plugin, or lazily if the types are registered by hand.
+    DashboardService *service = engine->findChild<DashboardService *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!service) {
+        service = new DashboardService(engine);
+    }
+    return service;
+}
+
+QObject * DashboardService::singletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine)
+{
+    Q_UNUSED(scriptEngine)
+    DashboardService *service = instance(engine);
+    // Owned by the engine as a child, the singleton cleanup must not delete it
+    QQmlEngine::setObjectOwnership(service, QQmlEngine::CppOwnership);
+    return service;
+}
+
+QQmlEngine * DashboardService::engine() const
+{
+    Q_D(const DashboardService);
+    return d->engine;
+}
+
+WidgetFactory * DashboardService::factory() const
+{
+    Q_D(const DashboardService);
+    return d->factory;
+}
+
+WidgetComponentCache * DashboardService::componentCache() const
+{
+    Q_D(const DashboardService);
+    return d->componentCache;
+}
+
+WidgetManifestRegistry * DashboardService::manifestRegistry() const
+{
+    Q_D(const DashboardService);
+    return d->manifestRegistry;
+}
+
+// Timings of the creation stages, to find the widgets that are slow to load
+WidgetCreationStatistics * DashboardService::creationStatistics() const
+{
+    Q_D(const DashboardService);
+    return d->factory->statistics();
+}
+
+// Estimated footprint of the live widgets, per instance and per source
+WidgetMemoryAccounting * DashboardService::memoryAccounting() const
+{
+    Q_D(const DashboardService);
+    return d->factory->memoryAccounting();
+}
+
+// Backends post property updates here rather than on the widgets, so that
+// bursts are merged and bindings are only evaluated once per frame.
+WidgetUpdateCoalescer * DashboardService::updates() const
+{
+    Q_D(const DashboardService);
+    return d->updates;
+}
+
+WidgetTeardownScheduler * DashboardService::teardown() const
+{
+    Q_D(const DashboardService);
+    return d->teardown;
+}
+
+int DashboardService::incubationBudget() const
+{
+    Q_D(const DashboardService);
+    return d->factory->incubationBudget();
+}
+
+void DashboardService::setIncubationBudget(int incubationBudget)
+{
+    Q_D(DashboardService);
+    // The factory clamps the budget, only its effective value is notified
+    int oldIncubationBudget = d->factory->incubationBudget();
+    d->factory->setIncubationBudget(incubationBudget);
+    if (d->factory->incubationBudget() != oldIncubationBudget) {
+        emit incubationBudgetChanged();
+    }
+}
+
+int DashboardService::pendingCount() const
+{
+    Q_D(const DashboardService);
+    return d->factory->pendingCount();
+}
+
+int DashboardService::visiblePendingCount() const
+{
+    Q_D(const DashboardService);
+    return d->factory->visiblePendingCount();
+}
+
+// Tracing is enabled while a file is set, and the file is written when
+// tracing stops. Setting another file starts a new trace.
+QString DashboardService::traceFile() const
+{
+    return WidgetTrace::fileName();
+}
+
+void DashboardService::setTraceFile(const QString &traceFile)
+{
+    Q_D(DashboardService);
+    if (WidgetTrace::fileName() != traceFile) {
+        if (traceFile.isEmpty()) {
+            WidgetTrace::stop();
+        } else {
+            WidgetTrace::start(traceFile);
+        }
+        d->traceFile = traceFile;
+        emit traceFileChanged();
+    }
+}
+
+// Disabled by default, since widgets are not all written to be reused
+int DashboardService::poolCapacity() const
+{
+    Q_D(const DashboardService);
+    return d->factory->poolCapacity();
+}
+
+void DashboardService::setPoolCapacity(int poolCapacity)
+{
+    Q_D(DashboardService);
+    int oldPoolCapacity = d->factory->poolCapacity();
+    d->factory->setPoolCapacity(poolCapacity);
+    if (d->factory->poolCapacity() != oldPoolCapacity) {
+        emit poolCapacityChanged();
+    }
+}
+
+int DashboardService::pooledCount() const
+{
+    Q_D(const DashboardService);
+    return d->factory->pooledCount();
+}
+
+// In bytes of resident memory, above which widgets are not pooled anymore
+// and the pool is emptied. 0, the default, is no limit.
+qint64 DashboardService::poolMemoryLimit() const
+{
+    Q_D(const DashboardService);
+    return d->factory->poolMemoryLimit();
+}
+
+void DashboardService::setPoolMemoryLimit(qint64 poolMemoryLimit)
+{
+    Q_D(DashboardService);
+    qint64 oldPoolMemoryLimit = d->factory->poolMemoryLimit();
+    d->factory->setPoolMemoryLimit(poolMemoryLimit);
+    if (d->factory->poolMemoryLimit() != oldPoolMemoryLimit) {
+        emit poolMemoryLimitChanged();
+    }
+}
+
+void DashboardService::clearPool()
+{
+    Q_D(DashboardService);
+    d->factory->clearPool();
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef DASHBOARDSERVICE_H
+#define DASHBOARDSERVICE_H
+
+#include <QtCore/QObject>
+#include "widgetcomponentcache.h"
+#include "widgetcreationstatistics.h"
+#include "widgetmemoryaccounting.h"
+#include "widgetteardownscheduler.h"
+#include "widgetupdatecoalescer.h"
+
+class QJSEngine;
+class QQmlEngine;
+class WidgetFactory;
+class WidgetManifestRegistry;
+class DashboardServicePrivate;
+class DashboardService : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(WidgetComponentCache * componentCache READ componentCache CONSTANT)
+    Q_PROPERTY(WidgetCreationStatistics * creationStatistics READ creationStatistics CONSTANT)
+    Q_PROPERTY(WidgetMemoryAccounting * memoryAccounting READ memoryAccounting CONSTANT)
+    Q_PROPERTY(WidgetUpdateCoalescer * updates READ updates CONSTANT)
+    Q_PROPERTY(WidgetTeardownScheduler * teardown READ teardown CONSTANT)
+    Q_PROPERTY(int incubationBudget READ incubationBudget WRITE setIncubationBudget
+               NOTIFY incubationBudgetChanged)
+    Q_PROPERTY(int pendingCount READ pendingCount NOTIFY pendingCountChanged)
+    Q_PROPERTY(int visiblePendingCount READ visiblePendingCount NOTIFY visiblePendingCountChanged)
+    Q_PROPERTY(QString traceFile READ traceFile WRITE setTraceFile NOTIFY traceFileChanged)
+    Q_PROPERTY(int poolCapacity READ poolCapacity WRITE setPoolCapacity NOTIFY poolCapacityChanged)
+    Q_PROPERTY(int pooledCount READ pooledCount NOTIFY pooledCountChanged)
+    Q_PROPERTY(qint64 poolMemoryLimit READ poolMemoryLimit WRITE setPoolMemoryLimit
+               NOTIFY poolMemoryLimitChanged)
+public:
+    virtual ~DashboardService();
+    static DashboardService * instance(QQmlEngine *engine);
+    static QObject * singletonProvider(QQmlEngine *engine, QJSEngine *scriptEngine);
+    QQmlEngine * engine() const;
+    WidgetFactory * factory() const;
+    WidgetComponentCache * componentCache() const;
+    WidgetManifestRegistry * manifestRegistry() const;
+    WidgetCreationStatistics * creationStatistics() const;
+    WidgetMemoryAccounting * memoryAccounting() const;
+    WidgetUpdateCoalescer * updates() const;
+    WidgetTeardownScheduler * teardown() const;
+    int incubationBudget() const;
+    void setIncubationBudget(int incubationBudget);
+    int pendingCount() const;
+    int visiblePendingCount() const;
+    QString traceFile() const;
+    void setTraceFile(const QString &traceFile);
+    int poolCapacity() const;
+    void setPoolCapacity(int poolCapacity);
+    int pooledCount() const;
+    qint64 poolMemoryLimit() const;
+    void setPoolMemoryLimit(qint64 poolMemoryLimit);
+public Q_SLOTS:
+    void clearPool();
+Q_SIGNALS:
+    void incubationBudgetChanged();
+    void pendingCountChanged();
+    void visiblePendingCountChanged();
+    void traceFileChanged();
+    void poolCapacityChanged();
+    void pooledCountChanged();
+    void poolMemoryLimitChanged();
+protected:
+    QScopedPointer<DashboardServicePrivate> d_ptr;
+private:
+    explicit DashboardService(QQmlEngine *engine);
+    Q_DECLARE_PRIVATE(DashboardService)
+};
+
+#endif // DASHBOARDSERVICE_H
@@ -30,37 +30,171 @@
  */
 
 #include "installedwidgetlistmodel.h"
+#include "dashboardservice.h"
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
-#include <QtCore/QJsonDocument>
-#include <QtCore/QJsonObject>
-#include <QtCore/QJsonValue>
-#include <QtCore/QUrl>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFileSystemWatcher>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
 #include <QtCore/QStringList>
+#include <QtCore/QTimer>
 #include <QtQml/QQmlContext>
 #include <QtQml/QQmlEngine>
-#include "widgetfactory.h"
+#include "widgetindex.h"
+#include "widgetmanifest.h"
+#include "widgetmanifestregistry.h"
+#include "widgettrace.h"
 
 static const char *DEFAULT_PATH = "/usr/share/dashboard/widgets";
+static const char *WIDGET_DESCRIPTION_FILE = "widget.json";
+static const int CHANGE_DELAY = 100;
 
 struct InstalledWidgetListModelItem
 {
     QString name;
     QString description;
     QString source;
+    QString path;
+    QDateTime modified;
+    WidgetManifest manifest;
 };
 
-class InstalledWidgetListModelPrivate
+struct InstalledWidgetListModelJob
 {
+    QString path;
+    bool force;
+};
+
+struct InstalledWidgetListModelListing
+{
+    QStringList packages;
+    QDateTime modified;
+};
+
+struct InstalledWidgetListModelCacheEntry
+{
+    QDateTime modified;
+    QList<InstalledWidgetListModelItem> items;
+};
+
+static bool itemLessThan(const InstalledWidgetListModelItem *item1,
+                         const InstalledWidgetListModelItem *item2)
+{
+    if (item1->name != item2->name) {
+        return item1->name < item2->name;
+    }
+    return item1->source < item2->source;
+}
+
+static bool isWatchable(const QString &path)
+{
+    return !path.startsWith(":") && !path.startsWith("qrc:");
+}
+
+static QDateTime pathLastModified(const QString &path)
+{
+    QFileInfo fileInfo (path);
+    if (!fileInfo.exists()) {
+        return QDateTime();
+    }
+    return fileInfo.lastModified();
+}
+
+static InstalledWidgetListModelListing listPackages(const QString &path)
+{
+    InstalledWidgetListModelListing listing;
+    QDir dir (path);
+    if (!dir.exists()) {
+        return listing;
+    }
+
+    // Taken before listing, so that a package added meanwhile invalidates the cache
+    listing.modified = pathLastModified(path);
+    QStringList subdirs = dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    foreach (const QString &subdirPaths, subdirs) {
+        QDir subdir (path);
+        if (!subdir.cd(subdirPaths)) {
+            continue;
+        }
+        listing.packages.append(subdir.absolutePath());
+    }
+    return listing;
+}
+
+static QStringList modifiedPackages(const QList<InstalledWidgetListModelItem> &items)
+{
+    QStringList packages;
+    foreach (const InstalledWidgetListModelItem &item, items) {
+        QString fileName = QDir(item.source).absoluteFilePath(WIDGET_DESCRIPTION_FILE);
+        if (pathLastModified(fileName) != item.modified) {
+            packages.append(item.source);
+        }
+    }
+    return packages;
+}
+
+static InstalledWidgetListModelItem * createItem(const WidgetManifest &manifest, const QString &path)
+{
+    InstalledWidgetListModelItem *item = new InstalledWidgetListModelItem;
+    item->name = manifest.name();
+    item->description = manifest.description();
+    item->source = manifest.source();
+    item->path = path;
+    item->modified = manifest.lastModified();
+    item->manifest = manifest;
+    return item;
+}
+
+class InstalledWidgetListModelPrivate: public QObject
+{
+    Q_OBJECT
 public:
     explicit InstalledWidgetListModelPrivate(InstalledWidgetListModel *q);
     virtual ~InstalledWidgetListModelPrivate();
-    void init();
+    QStringList allSearchPaths() const;
     void refresh();
+    void updateSearchPaths(const QStringList &oldSearchPaths);
+    void cancel();
+    void cancelPath(const QString &path);
+    void loadPath(const QString &path);
+    void scanPath(const QString &path, bool force);
+    bool restorePath(const QString &path);
+    void verifyPackages(const QString &path, const QList<InstalledWidgetListModelItem> &items);
+    void parse(const QString &path, const QStringList &packages);
+    void indexRead();
+    void packagesListed();
+    void packagesVerified();
+    void manifestsReady(int beginIndex, int endIndex);
+    void manifestsFinished();
+    void merge(QList<InstalledWidgetListModelItem *> batch);
+    void removeItems(const QSet<QString> &removedSources);
+    void updateWatchedPaths(const QStringList &paths);
+    void watchPackage(const QString &source);
+    void rewatchPackage(const QString &source);
+    void unwatchPackage(const QString &source);
+    void directoryChanged(const QString &path);
+    void fileChanged(const QString &file);
+    void processChanges();
+    void updateLoading();
     bool initialized;
+    bool loading;
     QStringList searchPaths;
+    QStringList watchedPaths;
     QList<InstalledWidgetListModelItem *> items;
-    WidgetFactory *factory;
+    QHash<QString, InstalledWidgetListModelItem *> sources;
+    QHash<QObject *, InstalledWidgetListModelJob> jobs;
+    QHash<QString, QDateTime> pathModified;
+    QHash<QString, InstalledWidgetListModelCacheEntry> cache;
+    QFileSystemWatcher *watcher;
+    QTimer *changeTimer;
+    QPointer<WidgetManifestRegistry> registry;
+    QSet<QString> changedPaths;
+    QSet<QString> changedPackages;
 protected:
     InstalledWidgetListModel * const q_ptr;
 private:
@@ -68,82 +202,588 @@ private:
 };
 
 InstalledWidgetListModelPrivate::InstalledWidgetListModelPrivate(InstalledWidgetListModel *q)
-    : initialized(false), factory(0), q_ptr(q)
+    : QObject(), initialized(false), loading(false), watcher(0), changeTimer(0), registry(0)
+    , q_ptr(q)
 {
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::directoryChanged,
+            this, &InstalledWidgetListModelPrivate::directoryChanged);
+    connect(watcher, &QFileSystemWatcher::fileChanged,
+            this, &InstalledWidgetListModelPrivate::fileChanged);
+
+    // Installing a package triggers a burst of notifications
+    changeTimer = new QTimer(this);
+    changeTimer->setSingleShot(true);
+    changeTimer->setInterval(CHANGE_DELAY);
+    connect(changeTimer, &QTimer::timeout, this, &InstalledWidgetListModelPrivate::processChanges);
 }
 
 InstalledWidgetListModelPrivate::~InstalledWidgetListModelPrivate()
 {
+    cancel();
+    if (registry) {
+        foreach (const InstalledWidgetListModelItem *item, items) {
+            registry->release(item->source);
+        }
+    }
     qDeleteAll(items);
 }
 
-void InstalledWidgetListModelPrivate::init()
+QStringList InstalledWidgetListModelPrivate::allSearchPaths() const
 {
-    Q_Q(InstalledWidgetListModel);
-    QQmlContext *context = QQmlEngine::contextForObject(q);
-    if (context) {
-        factory = new WidgetFactory(context->engine(), q);
-    } else {
-        qWarning() << "Failed to initialize widget factory. No widget will be available.";
-    }
-    initialized = true;
+    QStringList allSearchPaths;
+    allSearchPaths.append(DEFAULT_PATH);
+    allSearchPaths.append(searchPaths);
+    allSearchPaths.removeDuplicates();
+    return allSearchPaths;
 }
 
 void InstalledWidgetListModelPrivate::refresh()
 {
-    Q_Q(InstalledWidgetListModel);
+    WIDGET_TRACE("InstalledWidgetListModel::refresh");
+    if (!initialized) {
+        return;
+    }
+
+    cancel();
+    updateLoading();
+    QStringList paths = allSearchPaths();
+
+    // Packages from paths that are not searched anymore are dropped right away
+    QSet<QString> removedSources;
+    foreach (const InstalledWidgetListModelItem *item, items) {
+        if (!paths.contains(item->path)) {
+            removedSources.insert(item->source);
+        }
+    }
+    removeItems(removedSources);
+    updateWatchedPaths(paths);
+    pathModified.clear();
+    cache.clear();
 
+    foreach (const QString &path, paths) {
+        loadPath(path);
+    }
+}
+
+void InstalledWidgetListModelPrivate::updateSearchPaths(const QStringList &oldSearchPaths)
+{
     if (!initialized) {
         return;
     }
 
-    if (!factory) {
+    QStringList oldPaths;
+    oldPaths.append(DEFAULT_PATH);
+    oldPaths.append(oldSearchPaths);
+    oldPaths.removeDuplicates();
+    QStringList paths = allSearchPaths();
+
+    // Results of paths that are not searched anymore are kept, so that
+    // toggling a path back does not require scanning it again.
+    QSet<QString> removedSources;
+    foreach (const QString &path, oldPaths) {
+        if (paths.contains(path)) {
+            continue;
+        }
+
+        cancelPath(path);
+        // Pending changes would scan the path again
+        changedPaths.remove(path);
+        InstalledWidgetListModelCacheEntry entry;
+        entry.modified = pathModified.take(path);
+        foreach (const InstalledWidgetListModelItem *item, items) {
+            if (item->path == path) {
+                removedSources.insert(item->source);
+                changedPackages.remove(item->source);
+                entry.items.append(*item);
+            }
+        }
+        if (entry.modified.isValid()) {
+            cache.insert(path, entry);
+        }
+    }
+    removeItems(removedSources);
+    updateWatchedPaths(paths);
+
+    foreach (const QString &path, paths) {
+        if (oldPaths.contains(path)) {
+            continue;
+        }
+
+        if (!restorePath(path)) {
+            loadPath(path);
+        }
+    }
+    updateLoading();
+}
+
+void InstalledWidgetListModelPrivate::cancel()
+{
+    // Watchers are not reused, so that results from a previous refresh
+    // that are still queued cannot be delivered.
+    foreach (QObject *object, jobs.keys()) {
+        QFutureWatcherBase *futureWatcher = static_cast<QFutureWatcherBase *>(object);
+        futureWatcher->disconnect(this);
+        futureWatcher->cancel();
+        futureWatcher->deleteLater();
+    }
+    jobs.clear();
+    changedPaths.clear();
+    changedPackages.clear();
+    changeTimer->stop();
+}
+
+void InstalledWidgetListModelPrivate::cancelPath(const QString &path)
+{
+    foreach (QObject *object, jobs.keys()) {
+        if (jobs.value(object).path == path) {
+            QFutureWatcherBase *futureWatcher = static_cast<QFutureWatcherBase *>(object);
+            futureWatcher->disconnect(this);
+            futureWatcher->cancel();
+            futureWatcher->deleteLater();
+            jobs.remove(object);
+        }
+    }
+}
+
+void InstalledWidgetListModelPrivate::loadPath(const QString &path)
+{
+    // A fresh index written by dashboard-indexer replaces listing the
+    // directory and parsing every package.
+    QFutureWatcher<WidgetIndex> *indexWatcher = new QFutureWatcher<WidgetIndex>(this);
+    connect(indexWatcher, &QFutureWatcherBase::finished,
+            this, &InstalledWidgetListModelPrivate::indexRead);
+    InstalledWidgetListModelJob job;
+    job.path = path;
+    job.force = true;
+    jobs.insert(indexWatcher, job);
+    updateLoading();
+    indexWatcher->setFuture(QtConcurrent::run(&WidgetIndex::read, path));
+}
+
+void InstalledWidgetListModelPrivate::scanPath(const QString &path, bool force)
+{
+    // Walking the search path and parsing the descriptions both hit the
+    // disk, so both are done in the global thread pool. Results are merged
+    // into the model as they come.
+    QFutureWatcher<InstalledWidgetListModelListing> *listWatcher
+            = new QFutureWatcher<InstalledWidgetListModelListing>(this);
+    connect(listWatcher, &QFutureWatcherBase::finished,
+            this, &InstalledWidgetListModelPrivate::packagesListed);
+    InstalledWidgetListModelJob job;
+    job.path = path;
+    job.force = force;
+    jobs.insert(listWatcher, job);
+    updateLoading();
+    listWatcher->setFuture(QtConcurrent::run(listPackages, path));
+}
+
+bool InstalledWidgetListModelPrivate::restorePath(const QString &path)
+{
+    if (!cache.contains(path)) {
+        return false;
+    }
+
+    // An unchanged directory mtime means that no package was added or
+    // removed. Packages are still checked in the background, since
+    // widget.json might have been edited in place.
+    InstalledWidgetListModelCacheEntry entry = cache.take(path);
+    if (entry.modified != pathLastModified(path)) {
+        return false;
+    }
+
+    QList<InstalledWidgetListModelItem *> batch;
+    foreach (const InstalledWidgetListModelItem &item, entry.items) {
+        batch.append(new InstalledWidgetListModelItem(item));
+    }
+    merge(batch);
+    pathModified.insert(path, entry.modified);
+    verifyPackages(path, entry.items);
+    return true;
+}
+
+// Packages whose widget.json changed since it was read are parsed again
+void InstalledWidgetListModelPrivate::verifyPackages(const QString &path,
+                                                     const QList<InstalledWidgetListModelItem> &items)
+{
+    QFutureWatcher<QStringList> *verifyWatcher = new QFutureWatcher<QStringList>(this);
+    connect(verifyWatcher, &QFutureWatcherBase::finished,
+            this, &InstalledWidgetListModelPrivate::packagesVerified);
+    InstalledWidgetListModelJob job;
+    job.path = path;
+    job.force = false;
+    jobs.insert(verifyWatcher, job);
+    updateLoading();
+    verifyWatcher->setFuture(QtConcurrent::run(modifiedPackages, items));
+}
+
+void InstalledWidgetListModelPrivate::parse(const QString &path, const QStringList &packages)
+{
+    if (packages.isEmpty()) {
+        return;
+    }
+
+    QFutureWatcher<WidgetManifest> *manifestWatcher = new QFutureWatcher<WidgetManifest>(this);
+    connect(manifestWatcher, &QFutureWatcherBase::resultsReadyAt,
+            this, &InstalledWidgetListModelPrivate::manifestsReady);
+    connect(manifestWatcher, &QFutureWatcherBase::finished,
+            this, &InstalledWidgetListModelPrivate::manifestsFinished);
+    InstalledWidgetListModelJob job;
+    job.path = path;
+    job.force = false;
+    jobs.insert(manifestWatcher, job);
+    updateLoading();
+    manifestWatcher->setFuture(QtConcurrent::mapped(packages, &WidgetManifest::read));
+}
+
+void InstalledWidgetListModelPrivate::indexRead()
+{
+    QFutureWatcher<WidgetIndex> *indexWatcher = static_cast<QFutureWatcher<WidgetIndex> *>(sender());
+    InstalledWidgetListModelJob job = jobs.take(indexWatcher);
+    WidgetIndex index = indexWatcher->result();
+    indexWatcher->deleteLater();
+
+    if (!index.isValid()) {
+        scanPath(job.path, true);
+        updateLoading();
         return;
     }
 
-    QStringList allSearchPaths;
-    allSearchPaths.append(DEFAULT_PATH);
-    allSearchPaths.append(searchPaths);
+    pathModified.insert(job.path, index.lastModified());
+    QSet<QString> indexedSources;
+    QList<InstalledWidgetListModelItem *> batch;
+    foreach (const WidgetManifest &manifest, index.manifests()) {
+        indexedSources.insert(manifest.source());
+        batch.append(createItem(manifest, job.path));
+    }
+
+    QSet<QString> removedSources;
+    foreach (const InstalledWidgetListModelItem *item, items) {
+        if (item->path == job.path && !indexedSources.contains(item->source)) {
+            removedSources.insert(item->source);
+        }
+    }
+    removeItems(removedSources);
+    merge(batch);
 
-    QMap <QString, InstalledWidgetListModelItem *> sortedItems;
-    foreach (const QString &path, allSearchPaths) {
-        QDir dir (path);
-        if (!dir.exists()) {
+    // The index is written again when packages are installed or upgraded,
+    // so the directory mtime is trusted: checking every widget.json would
+    // cost what the index saves at startup. Later changes are reported by
+    // the watcher.
+    updateLoading();
+}
+
+void InstalledWidgetListModelPrivate::packagesListed()
+{
+    QFutureWatcher<InstalledWidgetListModelListing> *listWatcher
+            = static_cast<QFutureWatcher<InstalledWidgetListModelListing> *>(sender());
+    InstalledWidgetListModelJob job = jobs.take(listWatcher);
+    InstalledWidgetListModelListing listing = listWatcher->result();
+    const QStringList &packages = listing.packages;
+    listWatcher->deleteLater();
+    pathModified.insert(job.path, listing.modified);
+
+    // Removed packages
+    QSet<QString> listedSources = packages.toSet();
+    QSet<QString> removedSources;
+    foreach (const InstalledWidgetListModelItem *item, items) {
+        if (item->path == job.path && !listedSources.contains(item->source)) {
+            removedSources.insert(item->source);
+        }
+    }
+    removeItems(removedSources);
+
+    // Added packages. Known packages are only parsed again on a full
+    // refresh, otherwise the watcher tells us when they change.
+    QStringList parsedPackages;
+    foreach (const QString &package, packages) {
+        if (job.force || !sources.contains(package)) {
+            parsedPackages.append(package);
+        }
+    }
+    parse(job.path, parsedPackages);
+    updateLoading();
+}
+
+void InstalledWidgetListModelPrivate::packagesVerified()
+{
+    QFutureWatcher<QStringList> *verifyWatcher = static_cast<QFutureWatcher<QStringList> *>(sender());
+    InstalledWidgetListModelJob job = jobs.take(verifyWatcher);
+    QStringList packages = verifyWatcher->result();
+    verifyWatcher->deleteLater();
+    parse(job.path, packages);
+    updateLoading();
+}
+
+void InstalledWidgetListModelPrivate::manifestsReady(int beginIndex, int endIndex)
+{
+    QFutureWatcher<WidgetManifest> *manifestWatcher = static_cast<QFutureWatcher<WidgetManifest> *>(sender());
+    const InstalledWidgetListModelJob &job = jobs[manifestWatcher];
+    QList<InstalledWidgetListModelItem *> batch;
+    QSet<QString> invalidSources;
+    for (int i = beginIndex; i < endIndex; ++i) {
+        const WidgetManifest &manifest = manifestWatcher->resultAt(i);
+        if (!manifest.isValid()) {
+            invalidSources.insert(manifest.source());
+            continue;
+        }
+
+        batch.append(createItem(manifest, job.path));
+    }
+    removeItems(invalidSources);
+    merge(batch);
+}
+
+void InstalledWidgetListModelPrivate::manifestsFinished()
+{
+    jobs.remove(sender());
+    sender()->deleteLater();
+    updateLoading();
+}
+
+void InstalledWidgetListModelPrivate::merge(QList<InstalledWidgetListModelItem *> batch)
+{
+    WIDGET_TRACE("InstalledWidgetListModel::merge");
+    Q_Q(InstalledWidgetListModel);
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    int oldCount = items.count();
+
+    // Packages that are already known are updated in place
+    QList<InstalledWidgetListModelItem *>::iterator it = batch.begin();
+    while (it != batch.end()) {
+        InstalledWidgetListModelItem *newItem = *it;
+        InstalledWidgetListModelItem *item = sources.value(newItem->source, 0);
+        if (!item) {
+            ++it;
             continue;
         }
 
-        QStringList subdirs = dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
-        foreach (const QString &subdirPaths, subdirs) {
-            QDir subdir (path);
-            if (!subdir.cd(subdirPaths)) {
-                continue;
+        // Replacing widget.json drops the file from the watcher
+        rewatchPackage(item->source);
+
+        QList<InstalledWidgetListModelItem *>::iterator position
+                = qLowerBound(items.begin(), items.end(), item, itemLessThan);
+        int row = position - items.begin();
+        if (item->name == newItem->name) {
+            item->modified = newItem->modified;
+            item->manifest = newItem->manifest;
+            if (registry) {
+                registry->insert(item->manifest);
+            }
+            if (item->description != newItem->description) {
+                item->description = newItem->description;
+                emit q->dataChanged(q->index(row), q->index(row));
+            }
+            delete newItem;
+            it = batch.erase(it);
+        } else {
+            // The sort key changed: remove it and insert it again with the new ones
+            q->beginRemoveRows(QModelIndex(), row, row);
+            items.removeAt(row);
+            sources.remove(item->source);
+            if (registry) {
+                registry->release(item->source);
             }
+            delete item;
+            q->endRemoveRows();
+            ++it;
+        }
+    }
 
-            if (!factory->readSource(subdir.absolutePath())) {
-                continue;
+    // New packages are inserted as contiguous sorted runs
+    qSort(batch.begin(), batch.end(), itemLessThan);
+    int i = 0;
+    while (i < batch.count()) {
+        QList<InstalledWidgetListModelItem *>::iterator position
+                = qLowerBound(items.begin(), items.end(), batch.at(i), itemLessThan);
+        int row = position - items.begin();
+        int last = i + 1;
+        if (row < items.count()) {
+            const InstalledWidgetListModelItem *next = items.at(row);
+            while (last < batch.count() && itemLessThan(batch.at(last), next)) {
+                ++last;
             }
+        } else {
+            last = batch.count();
+        }
 
-            InstalledWidgetListModelItem *item = new InstalledWidgetListModelItem;
-            item->name = factory->widgetName();
-            item->description = factory->widgetDescription();
-            item->source = subdir.absolutePath();
-            sortedItems.insert(item->name, item);
+        q->beginInsertRows(QModelIndex(), row, row + last - i - 1);
+        for (int j = i; j < last; ++j) {
+            items.insert(row + j - i, batch.at(j));
+            sources.insert(batch.at(j)->source, batch.at(j));
+            watchPackage(batch.at(j)->source);
+            if (registry) {
+                // Shared with WidgetListModel, so that adding a widget does not read it again
+                registry->retain(batch.at(j)->manifest);
+            }
         }
+        q->endInsertRows();
+        i = last;
     }
 
-    if (!items.isEmpty()) {
-        q->beginRemoveRows(QModelIndex(), 0, q->rowCount() - 1);
-        qDeleteAll(items);
-        q->endRemoveRows();
+    if (items.count() != oldCount) {
+        emit q->countChanged();
     }
+}
 
-    if (!sortedItems.isEmpty()) {
-        q->beginInsertRows(QModelIndex(), 0, sortedItems.count() - 1);
-        foreach (InstalledWidgetListModelItem *item, sortedItems) {
-            items.append(item);
+void InstalledWidgetListModelPrivate::removeItems(const QSet<QString> &removedSources)
+{
+    WIDGET_TRACE("InstalledWidgetListModel::removeItems");
+    Q_Q(InstalledWidgetListModel);
+    if (removedSources.isEmpty()) {
+        return;
+    }
+
+    int oldCount = items.count();
+    int row = items.count() - 1;
+    while (row >= 0) {
+        if (!removedSources.contains(items.at(row)->source)) {
+            --row;
+            continue;
         }
+
+        // Remove contiguous runs of packages at once
+        int first = row;
+        while (first > 0 && removedSources.contains(items.at(first - 1)->source)) {
+            --first;
+        }
+
+        q->beginRemoveRows(QModelIndex(), first, row);
+        for (int i = row; i >= first; --i) {
+            InstalledWidgetListModelItem *item = items.takeAt(i);
+            sources.remove(item->source);
+            unwatchPackage(item->source);
+            // Other models might still list the package
+            if (registry) {
+                registry->release(item->source);
+            }
+            delete item;
+        }
+        q->endRemoveRows();
+        row = first - 1;
+    }
+
+    if (items.count() != oldCount) {
         emit q->countChanged();
-        q->endInsertRows();
+    }
+}
+
+void InstalledWidgetListModelPrivate::updateWatchedPaths(const QStringList &paths)
+{
+    foreach (const QString &path, watchedPaths) {
+        if (!paths.contains(path)) {
+            watcher->removePath(path);
+        }
+    }
+
+    QStringList newWatchedPaths;
+    foreach (const QString &path, paths) {
+        if (!isWatchable(path) || !QDir(path).exists()) {
+            continue;
+        }
+
+        if (!watchedPaths.contains(path)) {
+            watcher->addPath(path);
+        }
+        newWatchedPaths.append(path);
+    }
+    watchedPaths = newWatchedPaths;
+}
+
+void InstalledWidgetListModelPrivate::watchPackage(const QString &source)
+{
+    if (!isWatchable(source)) {
+        return;
+    }
+
+    // The directory tells when widget.json is created or replaced, the
+    // file when it is modified in place.
+    watcher->addPath(source);
+    QString fileName = QDir(source).absoluteFilePath(WIDGET_DESCRIPTION_FILE);
+    if (QFile::exists(fileName)) {
+        watcher->addPath(fileName);
+    }
+}
+
+void InstalledWidgetListModelPrivate::rewatchPackage(const QString &source)
+{
+    if (!isWatchable(source)) {
+        return;
+    }
+
+    QString fileName = QDir(source).absoluteFilePath(WIDGET_DESCRIPTION_FILE);
+    if (!watcher->files().contains(fileName) && QFile::exists(fileName)) {
+        watcher->addPath(fileName);
+    }
+}
+
+void InstalledWidgetListModelPrivate::unwatchPackage(const QString &source)
+{
+    if (!isWatchable(source)) {
+        return;
+    }
+
+    QStringList paths;
+    paths.append(source);
+    paths.append(QDir(source).absoluteFilePath(WIDGET_DESCRIPTION_FILE));
+    watcher->removePaths(paths);
+}
+
+void InstalledWidgetListModelPrivate::directoryChanged(const QString &path)
+{
+    if (watchedPaths.contains(path)) {
+        changedPaths.insert(path);
+    } else if (sources.contains(path)) {
+        changedPackages.insert(path);
+    } else {
+        return;
+    }
+    changeTimer->start();
+}
+
+void InstalledWidgetListModelPrivate::fileChanged(const QString &file)
+{
+    QString source = QFileInfo(file).absolutePath();
+    if (!sources.contains(source)) {
+        return;
+    }
+    changedPackages.insert(source);
+    changeTimer->start();
+}
+
+void InstalledWidgetListModelPrivate::processChanges()
+{
+    foreach (const QString &path, changedPaths) {
+        scanPath(path, false);
+    }
+    changedPaths.clear();
+
+    // Only the packages that changed are parsed again
+    QHash<QString, QStringList> packages;
+    foreach (const QString &source, changedPackages) {
+        const InstalledWidgetListModelItem *item = sources.value(source, 0);
+        if (item) {
+            packages[item->path].append(source);
+        }
+    }
+    changedPackages.clear();
+
+    QHash<QString, QStringList>::const_iterator it;
+    for (it = packages.constBegin(); it != packages.constEnd(); ++it) {
+        parse(it.key(), it.value());
+    }
+}
+
+void InstalledWidgetListModelPrivate::updateLoading()
+{
+    Q_Q(InstalledWidgetListModel);
+    bool newLoading = !jobs.isEmpty();
+    if (loading != newLoading) {
+        loading = newLoading;
+        emit q->loadingChanged();
     }
 }
 
@@ -163,10 +803,13 @@ void InstalledWidgetListModel::classBegin()
 void InstalledWidgetListModel::componentComplete()
 {
     Q_D(InstalledWidgetListModel);
-    d->init();
+    QQmlContext *context = QQmlEngine::contextForObject(this);
+    if (context) {
+        d->registry = DashboardService::instance(context->engine())->manifestRegistry();
+    }
+    d->initialized = true;
     d->refresh();
 }
-
 int InstalledWidgetListModel::rowCount(const QModelIndex &index) const
 {
     Q_UNUSED(index)
@@ -204,6 +847,12 @@ int InstalledWidgetListModel::count() const
     return rowCount();
 }
 
+bool InstalledWidgetListModel::isLoading() const
+{
+    Q_D(const InstalledWidgetListModel);
+    return d->loading;
+}
+
 QStringList InstalledWidgetListModel::searchPaths() const
 {
     Q_D(const InstalledWidgetListModel);
@@ -214,8 +863,9 @@ void InstalledWidgetListModel::setSearchPaths(const QStringList &searchPaths)
 {
     Q_D(InstalledWidgetListModel);
     if (d->searchPaths != searchPaths) {
+        QStringList oldSearchPaths = d->searchPaths;
         d->searchPaths = searchPaths;
-        d->refresh();
+        d->updateSearchPaths(oldSearchPaths);
         emit searchPathsChanged();
     }
 }
@@ -228,3 +878,5 @@ QHash<int, QByteArray> InstalledWidgetListModel::roleNames() const
     roles.insert(SourceRole, "source");
     return roles;
 }
+
+#include "installedwidgetlistmodel.moc"
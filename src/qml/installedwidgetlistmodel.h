@@ -42,6 +42,7 @@ class InstalledWidgetListModel : public QAbstractListModel, public QQmlParserSta
     Q_INTERFACES(QQmlParserStatus)
     Q_PROPERTY(int count READ count NOTIFY countChanged)
     Q_PROPERTY(QStringList searchPaths READ searchPaths WRITE setSearchPaths NOTIFY searchPathsChanged)
+    Q_PROPERTY(bool loading READ isLoading NOTIFY loadingChanged)
 public:
     enum Roles {
         NameRole,
@@ -56,11 +57,13 @@ public:
     int rowCount(const QModelIndex &index = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role) const;
     int count() const;
+    bool isLoading() const;
     QStringList searchPaths() const;
     void setSearchPaths(const QStringList &searchPaths);
 Q_SIGNALS:
     void countChanged();
     void searchPathsChanged();
+    void loadingChanged();
 protected:
     QHash<int, QByteArray> roleNames() const;
     QScopedPointer<InstalledWidgetListModelPrivate> d_ptr;
@@ -32,8 +32,17 @@
 # include <QtQml/qqml.h>
 # include <QtQml/QQmlEngine>
 # include <QtQml/QQmlExtensionPlugin>
+#include "dashboardservice.h"
+#include "widgetcomponentcache.h"
 #include "widgetcontextinfo.h"
+#include "widgetcreationstatistics.h"
+#include "widgetinputcontroller.h"
+#include "widgetlayout.h"
+#include "widgetlayoutindex.h"
 #include "widgetlistmodel.h"
+#include "widgetmemoryaccounting.h"
+#include "widgetteardownscheduler.h"
+#include "widgetupdatecoalescer.h"
 #include "installedwidgetlistmodel.h"
 
 class Widgets2Plugin : public QQmlExtensionPlugin
@@ -46,8 +55,8 @@ public:
     void initializeEngine(QQmlEngine *engine, const char *uri)
     {
         Q_UNUSED(uri)
-        Q_UNUSED(engine)
         Q_ASSERT(uri == QLatin1String("org.SfietKonstantin.widgets"));
+        DashboardService::instance(engine);
     }
 
     void registerTypes(const char *uri)
@@ -56,6 +65,16 @@ public:
         qmlRegisterUncreatableType<WidgetContextInfo>(uri, 2, 0, "Widget", "Cannot be created");
         qmlRegisterType<InstalledWidgetListModel>(uri, 2, 0, "InstalledWidgetListModel");
         qmlRegisterType<WidgetListModel>(uri, 2, 0, "WidgetListModel");
+        qmlRegisterType<WidgetInputController>(uri, 2, 0, "WidgetInputController");
+        qmlRegisterType<WidgetLayout>(uri, 2, 0, "WidgetLayout");
+        qmlRegisterType<WidgetLayoutIndex>(uri, 2, 0, "WidgetLayoutIndex");
+        qmlRegisterUncreatableType<WidgetComponentCache>(uri, 2, 0, "WidgetComponentCache", "Cannot be created");
+        qmlRegisterUncreatableType<WidgetCreationStatistics>(uri, 2, 0, "WidgetCreationStatistics",
+                                                             "Cannot be created");
+        qmlRegisterUncreatableType<WidgetMemoryAccounting>(uri, 2, 0, "WidgetMemoryAccounting", "Cannot be created");
+        qmlRegisterUncreatableType<WidgetTeardownScheduler>(uri, 2, 0, "WidgetTeardownScheduler", "Cannot be created");
+        qmlRegisterUncreatableType<WidgetUpdateCoalescer>(uri, 2, 0, "WidgetUpdateCoalescer", "Cannot be created");
+        qmlRegisterSingletonType<DashboardService>(uri, 2, 0, "Dashboard", DashboardService::singletonProvider);
     }
 };
 
@@ -4,19 +4,48 @@ PLUGIN_IMPORT_PATH = org/SfietKonstantin/dashboard
 TEMPLATE = lib
 CONFIG += qt plugin hide_symbols
 
-QT = core gui qml quick
+QT = core gui qml quick concurrent
+
+# Static tracepoints, needs sys/sdt.h from SystemTap
+dashboard_sdt: DEFINES += DASHBOARD_SDT
 
 HEADERS += \
+    dashboardservice.h \
+    widgetcomponentcache.h \
     widgetcontextinfo.h \
+    widgetcreationstatistics.h \
     widgetfactory.h \
+    widgetindex.h \
+    widgetinputcontroller.h \
+    widgetlayout.h \
+    widgetlayoutindex.h \
     widgetlistmodel.h \
+    widgetmanifest.h \
+    widgetmanifestregistry.h \
+    widgetmemoryaccounting.h \
+    widgetteardownscheduler.h \
+    widgettrace.h \
+    widgetupdatecoalescer.h \
     installedwidgetlistmodel.h
 
 SOURCES += \
     plugin.cpp \
+    dashboardservice.cpp \
+    widgetcomponentcache.cpp \
     widgetcontextinfo.cpp \
+    widgetcreationstatistics.cpp \
     widgetfactory.cpp \
+    widgetindex.cpp \
+    widgetinputcontroller.cpp \
+    widgetlayout.cpp \
+    widgetlayoutindex.cpp \
     widgetlistmodel.cpp \
+    widgetmanifest.cpp \
+    widgetmanifestregistry.cpp \
+    widgetmemoryaccounting.cpp \
+    widgetteardownscheduler.cpp \
+    widgettrace.cpp \
+    widgetupdatecoalescer.cpp \
     installedwidgetlistmodel.cpp
 
 OTHER_FILES += \
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetcomponentcache.h"
+#include <QtCore/QHash>
+#include <QtCore/QUrl>
+#include <QtQml/QQmlComponent>
+#include <QtQml/QQmlEngine>
+
+class WidgetComponentCachePrivate
+{
+public:
+    explicit WidgetComponentCachePrivate(WidgetComponentCache *q);
+    QQmlEngine *engine;
+    QHash<QUrl, QQmlComponent *> components;
+    int hitCount;
+    int missCount;
+protected:
+    WidgetComponentCache * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetComponentCache)
+};
+
+WidgetComponentCachePrivate::WidgetComponentCachePrivate(WidgetComponentCache *q)
+    : engine(0), hitCount(0), missCount(0), q_ptr(q)
+{
+}
+
+WidgetComponentCache::WidgetComponentCache(QQmlEngine *engine, QObject *parent)
+    : QObject(parent), d_ptr(new WidgetComponentCachePrivate(this))
+{
+    Q_D(WidgetComponentCache);
+    d->engine = engine;
+}
+
+WidgetComponentCache::~WidgetComponentCache()
+{
+}
+
+QQmlComponent * WidgetComponentCache::component(const QUrl &url)
+{
+    Q_D(WidgetComponentCache);
+    QQmlComponent *component = d->components.value(url, 0);
+    if (component) {
+        ++d->hitCount;
+        emit statisticsChanged();
+        return component;
+    }
+
+    ++d->missCount;
+    component = new QQmlComponent(d->engine, url, QQmlComponent::Asynchronous, this);
+    d->components.insert(url, component);
+    emit statisticsChanged();
+    emit countChanged();
+    return component;
+}
+
+bool WidgetComponentCache::contains(const QUrl &url) const
+{
+    Q_D(const WidgetComponentCache);
+    return d->components.contains(url);
+}
+
+int WidgetComponentCache::count() const
+{
+    Q_D(const WidgetComponentCache);
+    return d->components.count();
+}
+
+int WidgetComponentCache::hitCount() const
+{
+    Q_D(const WidgetComponentCache);
+    return d->hitCount;
+}
+
+int WidgetComponentCache::missCount() const
+{
+    Q_D(const WidgetComponentCache);
+    return d->missCount;
+}
+
+void WidgetComponentCache::evict(const QUrl &url)
+{
+    Q_D(WidgetComponentCache);
+    QQmlComponent *component = d->components.take(url);
+    if (!component) {
+        return;
+    }
+
+    // Objects already created from the component are not affected
+    component->deleteLater();
+    emit countChanged();
+}
+
+void WidgetComponentCache::clear()
+{
+    Q_D(WidgetComponentCache);
+    if (d->components.isEmpty()) {
+        return;
+    }
+
+    foreach (QQmlComponent *component, d->components) {
+        component->deleteLater();
+    }
+    d->components.clear();
+    emit countChanged();
+}
+
+void WidgetComponentCache::resetStatistics()
+{
+    Q_D(WidgetComponentCache);
+    d->hitCount = 0;
+    d->missCount = 0;
+    emit statisticsChanged();
+}
@@ -30,12 +30,139 @@
  */
 
 #include "widgetcontextinfo.h"
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtQml/QQmlPropertyMap>
+
+static const int POOL_BLOCK_SIZE = 32;
+
+// Context infos are created and deleted with the widgets of a dashboard.
+// They are allocated from blocks of chunks that are reused, so that adding
+// and removing widgets does not fragment the heap. A block is freed once
+// all its chunks are released, except for one spare block, so that the
+// memory used by a large dashboard is returned when it shrinks.
+class WidgetContextInfoPool
+{
+public:
+    static WidgetContextInfoPool * instance();
+    void * allocate();
+    void deallocate(void *pointer);
+private:
+    WidgetContextInfoPool();
+    struct Block;
+    struct Chunk
+    {
+        // First, so that a chunk and its data share the same address
+        union
+        {
+            Chunk *next;
+            char data[sizeof(WidgetContextInfo)];
+            qint64 alignment;
+            double doubleAlignment;
+        };
+        Block *block;
+    };
+    struct Block
+    {
+        Chunk chunks[POOL_BLOCK_SIZE];
+        Chunk *free;
+        int usedCount;
+    };
+    QMutex m_mutex;
+    // Blocks that have free chunks
+    QList<Block *> m_blocks;
+    Block *m_spare;
+};
+
+WidgetContextInfoPool::WidgetContextInfoPool()
+    : m_spare(0)
+{
+}
+
+WidgetContextInfoPool * WidgetContextInfoPool::instance()
+{
+    // Never deleted: context infos might be deleted late at exit
+    static WidgetContextInfoPool *pool = new WidgetContextInfoPool();
+    return pool;
+}
+
+void * WidgetContextInfoPool::allocate()
+{
+    QMutexLocker locker (&m_mutex);
+    if (m_blocks.isEmpty()) {
+        Block *block = m_spare;
+        m_spare = 0;
+        if (!block) {
+            block = new Block;
+            for (int i = 0; i < POOL_BLOCK_SIZE; ++i) {
+                block->chunks[i].next = i < POOL_BLOCK_SIZE - 1 ? &block->chunks[i + 1] : 0;
+                block->chunks[i].block = block;
+            }
+            block->free = &block->chunks[0];
+            block->usedCount = 0;
+        }
+        m_blocks.append(block);
+    }
+
+    Block *block = m_blocks.last();
+    Chunk *chunk = block->free;
+    block->free = chunk->next;
+    ++block->usedCount;
+    if (!block->free) {
+        m_blocks.removeLast();
+    }
+    return chunk;
+}
+
+void WidgetContextInfoPool::deallocate(void *pointer)
+{
+    QMutexLocker locker (&m_mutex);
+    Chunk *chunk = static_cast<Chunk *>(pointer);
+    Block *block = chunk->block;
+    if (!block->free) {
+        m_blocks.append(block);
+    }
+    chunk->next = block->free;
+    block->free = chunk;
+    --block->usedCount;
+
+    if (block->usedCount == 0) {
+        m_blocks.removeOne(block);
+        if (m_spare) {
+            delete block;
+        } else {
+            m_spare = block;
+        }
+    }
+}
 
 WidgetContextInfo::WidgetContextInfo(QObject *parent) :
-    QObject(parent), m_size(Medium)
+    QObject(parent), m_size(Medium), m_status(Null), m_settingValues(0), m_propertyValues(0)
 {
 }
 
+void * WidgetContextInfo::operator new(size_t size)
+{
+    // Subclasses do not fit in the chunks
+    if (size != sizeof(WidgetContextInfo)) {
+        return ::operator new(size);
+    }
+    return WidgetContextInfoPool::instance()->allocate();
+}
+
+void WidgetContextInfo::operator delete(void *pointer, size_t size)
+{
+    if (!pointer) {
+        return;
+    }
+
+    if (size != sizeof(WidgetContextInfo)) {
+        ::operator delete(pointer);
+        return;
+    }
+    WidgetContextInfoPool::instance()->deallocate(pointer);
+}
+
 WidgetContextInfo * WidgetContextInfo::create(WidgetSize size, QObject *parent)
 {
     WidgetContextInfo *widgetContextInfo = new WidgetContextInfo(parent);
@@ -56,19 +183,67 @@ void WidgetContextInfo::setSize(WidgetSize size)
     }
 }
 
+// Default settings come from the manifest and are shared between all the
+// instances of a widget. Only the keys that differ from the defaults are
+// stored per instance, and merged with the defaults when read.
 QVariantMap WidgetContextInfo::settings() const
 {
-    return m_settings;
+    if (m_settings.isEmpty()) {
+        return m_defaultSettings;
+    }
+
+    QVariantMap settings = m_defaultSettings;
+    QVariantMap::const_iterator i;
+    for (i = m_settings.constBegin(); i != m_settings.constEnd(); ++i) {
+        settings.insert(i.key(), i.value());
+    }
+    return settings;
 }
 
 void WidgetContextInfo::setSettings(const QVariantMap &settings)
 {
-    if (m_settings != settings) {
-        m_settings = settings;
+    // Defaults cannot be removed, missing keys fall back to them
+    QVariantMap overridden;
+    QVariantMap::const_iterator i;
+    for (i = settings.constBegin(); i != settings.constEnd(); ++i) {
+        QVariantMap::const_iterator defaultValue = m_defaultSettings.constFind(i.key());
+        if (defaultValue == m_defaultSettings.constEnd() || defaultValue.value() != i.value()) {
+            overridden.insert(i.key(), i.value());
+        }
+    }
+
+    if (m_settings != overridden) {
+        QVariantMap oldSettings = this->settings();
+        m_settings = overridden;
+        foreach (const QString &key, updateMap(m_settingValues, oldSettings, this->settings())) {
+            emit settingValueChanged(key);
+        }
+        emit settingsChanged();
+    }
+}
+
+QVariantMap WidgetContextInfo::defaultSettings() const
+{
+    return m_defaultSettings;
+}
+
+void WidgetContextInfo::setDefaultSettings(const QVariantMap &defaultSettings)
+{
+    if (m_defaultSettings != defaultSettings) {
+        QVariantMap oldSettings = settings();
+        m_defaultSettings = defaultSettings;
+        foreach (const QString &key, updateMap(m_settingValues, oldSettings, settings())) {
+            emit settingValueChanged(key);
+        }
         emit settingsChanged();
     }
 }
 
+QVariantMap WidgetContextInfo::overriddenSettings() const
+{
+    return m_settings;
+}
+
 QVariantMap WidgetContextInfo::properties() const
 {
     return m_properties;
@@ -77,7 +252,154 @@ QVariantMap WidgetContextInfo::properties() const
 void WidgetContextInfo::setProperties(const QVariantMap &properties)
 {
     if (m_properties != properties) {
+        QVariantMap oldProperties = m_properties;
         m_properties = properties;
+        foreach (const QString &key, updateMap(m_propertyValues, oldProperties, properties)) {
+            emit propertyValueChanged(key);
+        }
         emit propertiesChanged();
     }
 }
+
+// The maps are only created when used from QML. Bindings on one of their
+// keys are only notified when that key changes, while bindings on the
+// whole settings or properties are notified by settingsChanged and
+// propertiesChanged.
+QQmlPropertyMap * WidgetContextInfo::settingValues() const
+{
+    if (!m_settingValues) {
+        WidgetContextInfo *self = const_cast<WidgetContextInfo *>(this);
+        m_settingValues = new QQmlPropertyMap(self);
+        updateMap(m_settingValues, QVariantMap(), settings());
+        connect(m_settingValues, &QQmlPropertyMap::valueChanged, self, &WidgetContextInfo::settingValuesChanged);
+    }
+    return m_settingValues;
+}
+
+QQmlPropertyMap * WidgetContextInfo::propertyValues() const
+{
+    if (!m_propertyValues) {
+        WidgetContextInfo *self = const_cast<WidgetContextInfo *>(this);
+        m_propertyValues = new QQmlPropertyMap(self);
+        updateMap(m_propertyValues, QVariantMap(), m_properties);
+        connect(m_propertyValues, &QQmlPropertyMap::valueChanged,
+                self, &WidgetContextInfo::propertyValuesChanged);
+    }
+    return m_propertyValues;
+}
+
+QVariant WidgetContextInfo::settingValue(const QString &key) const
+{
+    QVariantMap::const_iterator i = m_settings.constFind(key);
+    if (i != m_settings.constEnd()) {
+        return i.value();
+    }
+    return m_defaultSettings.value(key);
+}
+
+void WidgetContextInfo::setSettingValue(const QString &key, const QVariant &value)
+{
+    if (!updateSettingValue(key, value)) {
+        return;
+    }
+
+    if (m_settingValues) {
+        m_settingValues->insert(key, value);
+    }
+    emit settingValueChanged(key);
+    emit settingsChanged();
+}
+
+QVariant WidgetContextInfo::propertyValue(const QString &key) const
+{
+    return m_properties.value(key);
+}
+
+void WidgetContextInfo::setPropertyValue(const QString &key, const QVariant &value)
+{
+    QVariantMap::iterator i = m_properties.find(key);
+    if (i != m_properties.end() && i.value() == value) {
+        return;
+    }
+
+    m_properties.insert(key, value);
+    if (m_propertyValues) {
+        m_propertyValues->insert(key, value);
+    }
+    emit propertyValueChanged(key);
+    emit propertiesChanged();
+}
+
+QStringList WidgetContextInfo::updateMap(QQmlPropertyMap *map, const QVariantMap &oldValues,
+                                         const QVariantMap &newValues)
+{
+    // Only changed keys are written, so that other bindings are left alone
+    QStringList changedKeys;
+    QVariantMap::const_iterator i;
+    for (i = oldValues.constBegin(); i != oldValues.constEnd(); ++i) {
+        if (!newValues.contains(i.key())) {
+            changedKeys.append(i.key());
+            if (map) {
+                map->clear(i.key());
+            }
+        }
+    }
+
+    for (i = newValues.constBegin(); i != newValues.constEnd(); ++i) {
+        QVariantMap::const_iterator oldValue = oldValues.constFind(i.key());
+        if (oldValue == oldValues.constEnd() || oldValue.value() != i.value()) {
+            changedKeys.append(i.key());
+            if (map) {
+                map->insert(i.key(), i.value());
+            }
+        }
+    }
+    return changedKeys;
+}
+
+bool WidgetContextInfo::updateSettingValue(const QString &key, const QVariant &value)
+{
+    if (settingValue(key) == value && (m_settings.contains(key) || m_defaultSettings.contains(key))) {
+        return false;
+    }
+
+    // Going back to the default drops the override
+    QVariantMap::const_iterator defaultValue = m_defaultSettings.constFind(key);
+    if (defaultValue != m_defaultSettings.constEnd() && defaultValue.value() == value) {
+        m_settings.remove(key);
+    } else {
+        m_settings.insert(key, value);
+    }
+    return true;
+}
+
+void WidgetContextInfo::settingValuesChanged(const QString &key, const QVariant &value)
+{
+    // Written from QML, the map is already up to date
+    if (updateSettingValue(key, value)) {
+        emit settingValueChanged(key);
+        emit settingsChanged();
+    }
+}
+
+void WidgetContextInfo::propertyValuesChanged(const QString &key, const QVariant &value)
+{
+    if (m_properties.value(key) != value) {
+        m_properties.insert(key, value);
+        emit propertyValueChanged(key);
+        emit propertiesChanged();
+    }
+}
+
+WidgetContextInfo::Status WidgetContextInfo::status() const
+{
+    return m_status;
+}
+
+void WidgetContextInfo::setStatus(Status status)
+{
+    if (m_status != status) {
+        m_status = status;
+        emit statusChanged();
+    }
+}
@@ -33,15 +33,21 @@
 #define WIDGETCONTEXTINFO_H
 
 #include <QtCore/QObject>
+#include <QtCore/QStringList>
 #include <QtCore/QVariantMap>
+#include <QtQml/QQmlPropertyMap>
 
 class WidgetContextInfo : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(WidgetSize size READ size NOTIFY sizeChanged)
-    Q_PROPERTY(QVariantMap settings READ settings NOTIFY propertiesChanged)
+    Q_PROPERTY(QVariantMap settings READ settings NOTIFY settingsChanged)
     Q_PROPERTY(QVariantMap properties READ properties WRITE setProperties NOTIFY propertiesChanged)
+    Q_PROPERTY(Status status READ status NOTIFY statusChanged)
+    Q_PROPERTY(QQmlPropertyMap * settingValues READ settingValues CONSTANT)
+    Q_PROPERTY(QQmlPropertyMap * propertyValues READ propertyValues CONSTANT)
     Q_ENUMS(WidgetSize)
+    Q_ENUMS(Status)
 public:
     enum WidgetSize
     {
@@ -49,22 +55,53 @@ public:
         Medium,
         Large
     };
+    enum Status
+    {
+        Null,
+        Loading,
+        Ready,
+        Error
+    };
     explicit WidgetContextInfo(QObject *parent = 0);
+    static void * operator new(size_t size);
+    static void operator delete(void *pointer, size_t size);
     static WidgetContextInfo * create(WidgetSize size, QObject *parent = 0);
     WidgetSize size() const;
     void setSize(WidgetSize size);
     QVariantMap settings() const;
     void setSettings(const QVariantMap &settings);
+    QVariantMap defaultSettings() const;
+    void setDefaultSettings(const QVariantMap &defaultSettings);
+    QVariantMap overriddenSettings() const;
     QVariantMap properties() const;
     void setProperties(const QVariantMap &properties);
+    QQmlPropertyMap * settingValues() const;
+    QQmlPropertyMap * propertyValues() const;
+    Q_INVOKABLE QVariant settingValue(const QString &key) const;
+    Q_INVOKABLE void setSettingValue(const QString &key, const QVariant &value);
+    Q_INVOKABLE QVariant propertyValue(const QString &key) const;
+    Q_INVOKABLE void setPropertyValue(const QString &key, const QVariant &value);
+    Status status() const;
+    void setStatus(Status status);
 Q_SIGNALS:
     void sizeChanged();
     void settingsChanged();
     void propertiesChanged();
+    void settingValueChanged(const QString &key);
+    void propertyValueChanged(const QString &key);
+    void statusChanged();
 private:
+    static QStringList updateMap(QQmlPropertyMap *map, const QVariantMap &oldValues, const QVariantMap &newValues);
+    bool updateSettingValue(const QString &key, const QVariant &value);
+    void settingValuesChanged(const QString &key, const QVariant &value);
+    void propertyValuesChanged(const QString &key, const QVariant &value);
     WidgetSize m_size;
+    Status m_status;
+    QVariantMap m_defaultSettings;
     QVariantMap m_settings;
     QVariantMap m_properties;
+    mutable QQmlPropertyMap *m_settingValues;
+    mutable QQmlPropertyMap *m_propertyValues;
 };
 
 #endif // WIDGETCONTEXTINFO_H
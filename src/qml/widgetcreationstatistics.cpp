@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetcreationstatistics.h"
+#include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QUrl>
+#include <QtCore/QVector>
+#include "widgetcontextinfo.h"
+
+// Statistics are computed on the last samples only, so that they follow
+// the widget when it is updated, or when the cache is warm.
+static const int WINDOW_SIZE = 64;
+static const int STAGE_COUNT = WidgetCreationStatistics::Total + 1;
+static const char *STAGE_NAMES[STAGE_COUNT] = {"compile", "beginCreate", "completeCreate", "incubate", "total"};
+static const char *COUNT_KEY = "count";
+static const char *MEAN_KEY = "mean";
+static const char *P95_KEY = "p95";
+static const char *MAX_KEY = "max";
+
+struct WidgetCreationSamples
+{
+    WidgetCreationSamples();
+    void append(qint64 nsecs);
+    QVariantMap toMap() const;
+    int count;
+    int next;
+    QVector<qint64> window;
+};
+
+WidgetCreationSamples::WidgetCreationSamples()
+    : count(0), next(0)
+{
+}
+
+void WidgetCreationSamples::append(qint64 nsecs)
+{
+    ++count;
+    if (window.count() < WINDOW_SIZE) {
+        window.append(nsecs);
+        return;
+    }
+    window[next] = nsecs;
+    next = (next + 1) % WINDOW_SIZE;
+}
+
+static double toMsecs(qint64 nsecs)
+{
+    return nsecs / 1000000.;
+}
+
+QVariantMap WidgetCreationSamples::toMap() const
+{
+    QVariantMap map;
+    map.insert(COUNT_KEY, count);
+    if (window.isEmpty()) {
+        return map;
+    }
+
+    QVector<qint64> sorted = window;
+    qSort(sorted);
+    qint64 sum = 0;
+    foreach (qint64 sample, sorted) {
+        sum += sample;
+    }
+
+    // Nearest rank
+    int p95Index = qMax(0, (sorted.count() * 95 + 99) / 100 - 1);
+    map.insert(MEAN_KEY, toMsecs(sum) / sorted.count());
+    map.insert(P95_KEY, toMsecs(sorted.at(p95Index)));
+    map.insert(MAX_KEY, toMsecs(sorted.last()));
+    return map;
+}
+
+struct WidgetCreationSourceSamples
+{
+    WidgetCreationSamples stages[STAGE_COUNT];
+};
+
+class WidgetCreationStatisticsPrivate: public QObject
+{
+    Q_OBJECT
+public:
+    explicit WidgetCreationStatisticsPrivate(WidgetCreationStatistics *q);
+    void contextInfoDestroyed(QObject *object);
+    QHash<QString, WidgetCreationSourceSamples> sources;
+    QHash<WidgetContextInfo *, QVariantMap> instances;
+    int sampleCount;
+    bool logEnabled;
+protected:
+    WidgetCreationStatistics * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetCreationStatistics)
+};
+
+WidgetCreationStatisticsPrivate::WidgetCreationStatisticsPrivate(WidgetCreationStatistics *q)
+    : QObject(), sampleCount(0), logEnabled(false), q_ptr(q)
+{
+}
+
+void WidgetCreationStatisticsPrivate::contextInfoDestroyed(QObject *object)
+{
+    instances.remove(static_cast<WidgetContextInfo *>(object));
+}
+
+WidgetCreationStatistics::WidgetCreationStatistics(QObject *parent) :
+    QObject(parent), d_ptr(new WidgetCreationStatisticsPrivate(this))
+{
+}
+
+WidgetCreationStatistics::~WidgetCreationStatistics()
+{
+}
+
+bool WidgetCreationStatistics::isLogEnabled() const
+{
+    Q_D(const WidgetCreationStatistics);
+    return d->logEnabled;
+}
+
+void WidgetCreationStatistics::setLogEnabled(bool logEnabled)
+{
+    Q_D(WidgetCreationStatistics);
+    if (d->logEnabled != logEnabled) {
+        d->logEnabled = logEnabled;
+        emit logEnabledChanged();
+    }
+}
+
+int WidgetCreationStatistics::sampleCount() const
+{
+    Q_D(const WidgetCreationStatistics);
+    return d->sampleCount;
+}
+
+// Samples are recorded by the factory. The compile stage is shared by all
+// the instances of a source, so it is only recorded per source.
+void WidgetCreationStatistics::record(const QUrl &source, WidgetContextInfo *widgetContextInfo, Stage stage,
+                                      qint64 nsecs)
+{
+    Q_D(WidgetCreationStatistics);
+    QString sourceString = source.toString();
+    d->sources[sourceString].stages[stage].append(nsecs);
+    ++d->sampleCount;
+
+    if (widgetContextInfo) {
+        if (!d->instances.contains(widgetContextInfo)) {
+            connect(widgetContextInfo, &QObject::destroyed,
+                    d, &WidgetCreationStatisticsPrivate::contextInfoDestroyed, Qt::UniqueConnection);
+        }
+        d->instances[widgetContextInfo].insert(STAGE_NAMES[stage], toMsecs(nsecs));
+    }
+
+    if (d->logEnabled) {
+        qDebug() << "Widget" << sourceString.toLocal8Bit().data() << STAGE_NAMES[stage]
+                 << toMsecs(nsecs) << "ms";
+    }
+    emit statisticsChanged();
+}
+
+QStringList WidgetCreationStatistics::sources() const
+{
+    Q_D(const WidgetCreationStatistics);
+    QStringList sources = d->sources.keys();
+    sources.sort();
+    return sources;
+}
+
+QVariantMap WidgetCreationStatistics::statistics(const QString &source) const
+{
+    Q_D(const WidgetCreationStatistics);
+    QVariantMap statistics;
+    QHash<QString, WidgetCreationSourceSamples>::const_iterator i = d->sources.constFind(source);
+    if (i == d->sources.constEnd()) {
+        return statistics;
+    }
+
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if (i.value().stages[stage].count > 0) {
+            statistics.insert(STAGE_NAMES[stage], i.value().stages[stage].toMap());
+        }
+    }
+    return statistics;
+}
+
+QVariantMap WidgetCreationStatistics::timings(WidgetContextInfo *widgetContextInfo) const
+{
+    Q_D(const WidgetCreationStatistics);
+    return d->instances.value(widgetContextInfo);
+}
+
+void WidgetCreationStatistics::dump() const
+{
+    Q_D(const WidgetCreationStatistics);
+    foreach (const QString &source, sources()) {
+        const WidgetCreationSourceSamples &samples = d->sources[source];
+        qDebug() << "Widget" << source.toLocal8Bit().data();
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            QVariantMap map = samples.stages[stage].toMap();
+            if (map.value(COUNT_KEY).toInt() == 0) {
+                continue;
+            }
+            qDebug() << "   " << STAGE_NAMES[stage] << "count" << map.value(COUNT_KEY).toInt()
+                     << "mean" << map.value(MEAN_KEY).toDouble() << "p95" << map.value(P95_KEY).toDouble()
+                     << "max" << map.value(MAX_KEY).toDouble();
+        }
+    }
+}
+
+void WidgetCreationStatistics::reset()
+{
+    Q_D(WidgetCreationStatistics);
+    d->sources.clear();
+    d->instances.clear();
+    d->sampleCount = 0;
+    emit statisticsChanged();
+}
+
+#include "widgetcreationstatistics.moc"
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef WIDGETCREATIONSTATISTICS_H
+#define WIDGETCREATIONSTATISTICS_H
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantMap>
+
+class QUrl;
+class WidgetContextInfo;
+class WidgetCreationStatisticsPrivate;
+class WidgetCreationStatistics : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(bool logEnabled READ isLogEnabled WRITE setLogEnabled NOTIFY logEnabledChanged)
+    Q_PROPERTY(int sampleCount READ sampleCount NOTIFY statisticsChanged)
+    Q_ENUMS(Stage)
+public:
+    enum Stage
+    {
+        Compile,
+        BeginCreate,
+        CompleteCreate,
+        Incubate,
+        Total
+    };
+    explicit WidgetCreationStatistics(QObject *parent = 0);
+    virtual ~WidgetCreationStatistics();
+    bool isLogEnabled() const;
+    void setLogEnabled(bool logEnabled);
+    int sampleCount() const;
+    void record(const QUrl &source, WidgetContextInfo *widgetContextInfo, Stage stage, qint64 nsecs);
+    Q_INVOKABLE QStringList sources() const;
+    Q_INVOKABLE QVariantMap statistics(const QString &source) const;
+    Q_INVOKABLE QVariantMap timings(WidgetContextInfo *widgetContextInfo) const;
+public Q_SLOTS:
+    void dump() const;
+    void reset();
+Q_SIGNALS:
+    void logEnabledChanged();
+    void statisticsChanged();
+protected:
+    QScopedPointer<WidgetCreationStatisticsPrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(WidgetCreationStatistics)
+};
+
+#endif // WIDGETCREATIONSTATISTICS_H
@@ -30,32 +30,136 @@
  */
 
 #include "widgetfactory.h"
+#include <QtCore/QBasicTimer>
 #include <QtCore/QDebug>
-#include <QtCore/QDir>
-#include <QtCore/QJsonDocument>
-#include <QtCore/QJsonObject>
-#include <QtCore/QJsonValue>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPair>
+#include <QtCore/QPointer>
+#include <QtCore/QTimerEvent>
+#include <QtCore/QUrl>
+#include <QtGui/QGuiApplication>
 #include <QtQml/QQmlComponent>
 #include <QtQml/QQmlContext>
 #include <QtQml/QQmlEngine>
+#include <QtQml/QQmlIncubator>
 #include <QtQuick/QQuickItem>
+#include "widgetcomponentcache.h"
 #include "widgetcontextinfo.h"
+#include "widgetcreationstatistics.h"
+#include "widgetmanifest.h"
+#include "widgetmemoryaccounting.h"
+#include "widgetteardownscheduler.h"
+#include "widgettrace.h"
 
-static const char *WIDGET_DESCRIPTION_FILE = "widget.json";
-static const char *WIDGET_FILE_NAME = "widget.qml";
-static const char *NAME_KEY = "name";
-static const char *DESCRIPTION_KEY = "description";
-static const char *DEFAULT_SETTINGS_KEY = "default_settings";
 static const char *SIZE_KEY = "size";
 static const char *SIZE_SMALL = "small";
 // static const char *SIZE_MEDIUM = "medium";
 static const char *SIZE_LARGE = "large";
 // static const char *DEFAULT_PROPERTIES_KEY = "default_properties";
 
+static const int DEFAULT_INCUBATION_BUDGET = 5;
+static const int INCUBATION_INTERVAL = 16;
+// Incubators are processed in creation order by the incubation controller,
+// so only a few are started at once, to keep the queue order meaningful.
+static const int MAXIMUM_INCUBATORS = 2;
+// Spans from the request of a widget to its creation, or cancellation
+static const char *REQUEST_TRACE_NAME = "WidgetFactory::request";
+
 struct WidgetFactoryContainer
 {
+    QUrl url;
+    // Resolved once per request, so that the cache statistics count
+    // requests, and not the times a request goes through the queue
+    QPointer<QQmlComponent> component;
     WidgetContextInfo *widgetContextInfo;
-    QObject *parent;
+    QPointer<QObject> parent;
+    bool asynchronous;
+    qreal priority;
+    QElapsedTimer requestTimer;
+};
+
+struct WidgetFactoryWidget
+{
+    QPointer<QObject> widget;
+    QPointer<QQmlContext> context;
+    QUrl url;
+};
+
+// Requests are sorted by priority, then by insertion order
+typedef QPair<qreal, quint64> WidgetFactoryQueueKey;
+
+class WidgetIncubationController: public QObject, public QQmlIncubationController
+{
+    Q_OBJECT
+public:
+    static void install(QQmlEngine *engine, int budget);
+    int budget;
+protected:
+    void incubatingObjectCountChanged(int incubatingObjectCount);
+    void timerEvent(QTimerEvent *event);
+private:
+    explicit WidgetIncubationController(QQmlEngine *engine);
+    QBasicTimer m_timer;
+};
+
+WidgetIncubationController::WidgetIncubationController(QQmlEngine *engine)
+    : QObject(engine), budget(DEFAULT_INCUBATION_BUDGET)
+{
+}
+
+// QQuickView and QQuickWindow install a controller that incubates between
+// frames, and that is shared by every asynchronous component of the engine:
+// it is kept. This one is only installed when the engine has none, so that
+// widgets are still incubated, with the budget of the factory.
+void WidgetIncubationController::install(QQmlEngine *engine, int budget)
+{
+    WidgetIncubationController *controller = engine->findChild<WidgetIncubationController *>(QString(),
+                                                                                           Qt::FindDirectChildrenOnly);
+    if (!controller) {
+        if (engine->incubationController()) {
+            return;
+        }
+        controller = new WidgetIncubationController(engine);
+        engine->setIncubationController(controller);
+    }
+    controller->budget = budget;
+}
+
+void WidgetIncubationController::incubatingObjectCountChanged(int incubatingObjectCount)
+{
+    if (incubatingObjectCount > 0 && !m_timer.isActive()) {
+        m_timer.start(INCUBATION_INTERVAL, this);
+    } else if (incubatingObjectCount == 0) {
+        m_timer.stop();
+    }
+}
+
+void WidgetIncubationController::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == m_timer.timerId()) {
+        incubateFor(budget);
+    }
+}
+
+class WidgetFactoryPrivate;
+class WidgetIncubator: public QQmlIncubator
+{
+public:
+    explicit WidgetIncubator(WidgetFactoryPrivate *factory, const QUrl &url,
+                             WidgetContextInfo *widgetContextInfo, QObject *parent, QQmlContext *context);
+    QUrl url;
+    WidgetContextInfo *widgetContextInfo;
+    QPointer<QObject> parent;
+    QQmlContext *context;
+    qreal priority;
+    QElapsedTimer requestTimer;
+    QElapsedTimer incubationTimer;
+    qint64 initialMemory;
+protected:
+    void setInitialState(QObject *object);
+    void statusChanged(Status status);
+private:
+    WidgetFactoryPrivate *m_factory;
 };
 
 class WidgetFactoryPrivate: public QObject
@@ -63,132 +167,818 @@ class WidgetFactoryPrivate: public QObject
     Q_OBJECT
 public:
     explicit WidgetFactoryPrivate(WidgetFactory *q);
+    virtual ~WidgetFactoryPrivate();
     void statusChanged(QQmlComponent::Status status);
-    void addWidget(QQmlComponent *component, WidgetContextInfo *widgetContextInfo, QObject *parent);
-    QMap<QQmlComponent *, WidgetFactoryContainer> infos;
+    void componentDestroyed(QObject *object);
+    QQmlComponent * component(const QUrl &url);
+    void recordCompile(QQmlComponent *component);
+    void enqueue(const WidgetFactoryContainer &container);
+    void scheduleQueue(int interval);
+    void processQueue();
+    void addWidget(QQmlComponent *component, const WidgetFactoryContainer &container);
+    void incubateWidget(QQmlComponent *component, const WidgetFactoryContainer &container);
+    void incubatorFinished(WidgetIncubator *incubator);
+    void widgetReady(WidgetContextInfo *widgetContextInfo, const QUrl &url, QObject *widget,
+                     QQmlContext *context);
+    bool reuseWidget(const WidgetFactoryContainer &container);
+    void releaseWidget(WidgetContextInfo *widgetContextInfo, bool recycle);
+    void poolWidget(const WidgetFactoryWidget &widget);
+    void trimPool(int capacity);
+    bool isLowOnMemory() const;
+    void applicationStateChanged(Qt::ApplicationState state);
+    void destroyWidget(QObject *widget);
+    void contextInfoDestroyed(QObject *object);
+    Q_INVOKABLE void deleteFinishedIncubators();
+    void trackPending(qreal priority, int delta);
+    void updatePendingCount();
+    static bool isVisible(qreal priority);
+    static void setParent(QObject *widget, QObject *parent);
+    QMap<WidgetFactoryQueueKey, WidgetFactoryContainer> queue;
+    quint64 queueSequence;
+    QBasicTimer queueTimer;
+    QMultiMap<QQmlComponent *, WidgetFactoryContainer> infos;
+    QList<WidgetIncubator *> incubators;
+    QList<WidgetIncubator *> finishedIncubators;
+    QHash<WidgetContextInfo *, WidgetFactoryWidget> widgets;
+    QList<WidgetFactoryWidget> pool;
+    WidgetContextInfo *pooledContextInfo;
+    int poolCapacity;
+    qint64 poolMemoryLimit;
     QQmlEngine *engine;
-    QString source;
-    QJsonObject widgetDescription;
+    WidgetComponentCache *cache;
+    QPointer<WidgetTeardownScheduler> teardown;
+    WidgetCreationStatistics *statistics;
+    WidgetMemoryAccounting *memoryAccounting;
+    QHash<QQmlComponent *, QElapsedTimer> compileTimers;
+    int incubationBudget;
+    int requestCount;
+    int visibleRequestCount;
+    int pendingCount;
+    int visiblePendingCount;
 protected:
+    void timerEvent(QTimerEvent *event);
     WidgetFactory * const q_ptr;
 private:
     Q_DECLARE_PUBLIC(WidgetFactory)
 };
 
+WidgetIncubator::WidgetIncubator(WidgetFactoryPrivate *factory, const QUrl &url,
+                                 WidgetContextInfo *widgetContextInfo, QObject *parent, QQmlContext *context)
+    : QQmlIncubator(Asynchronous), url(url), widgetContextInfo(widgetContextInfo), parent(parent)
+    , context(context), priority(0), initialMemory(-1), m_factory(factory)
+{
+}
+
+void WidgetIncubator::setInitialState(QObject *object)
+{
+    WidgetFactoryPrivate::setParent(object, parent);
+}
+
+void WidgetIncubator::statusChanged(Status status)
+{
+    if (status == Ready || status == Error) {
+        m_factory->incubatorFinished(this);
+    }
+}
+
 WidgetFactoryPrivate::WidgetFactoryPrivate(WidgetFactory *q)
-    : engine(0), q_ptr(q)
+    : queueSequence(0), pooledContextInfo(0), poolCapacity(0), poolMemoryLimit(0), engine(0), cache(0)
+    , statistics(0), memoryAccounting(0), incubationBudget(DEFAULT_INCUBATION_BUDGET)
+    , requestCount(0), visibleRequestCount(0), pendingCount(0), visiblePendingCount(0), q_ptr(q)
 {
+    if (qGuiApp) {
+        connect(qGuiApp, &QGuiApplication::applicationStateChanged,
+                this, &WidgetFactoryPrivate::applicationStateChanged);
+    }
+}
+
+WidgetFactoryPrivate::~WidgetFactoryPrivate()
+{
+    foreach (WidgetIncubator *incubator, incubators) {
+        incubator->clear();
+        delete incubator->context;
+    }
+    qDeleteAll(incubators);
+    qDeleteAll(finishedIncubators);
+    foreach (const WidgetFactoryWidget &entry, pool) {
+        delete entry.widget.data();
+    }
 }
 
 void WidgetFactoryPrivate::statusChanged(QQmlComponent::Status status)
 {
-    Q_UNUSED(status)
     QQmlComponent *component = qobject_cast<QQmlComponent *>(sender());
     if (!component) {
         return;
     }
 
-    if (!infos.contains(component)) {
-        component->deleteLater();
+    if (status != QQmlComponent::Ready && status != QQmlComponent::Error) {
         return;
     }
 
-    const WidgetFactoryContainer &container = infos[component];
-    WidgetContextInfo *widgetContextInfo = container.widgetContextInfo;
-    QObject *parent = container.parent;
-    addWidget(component, widgetContextInfo, parent);
+    // The component is shared through the cache, so several widgets might
+    // be waiting for it. They go back to the queue, so that they are still
+    // created by priority. QMultiMap::values returns the most recent first.
+    recordCompile(component);
+    QList<WidgetFactoryContainer> containers = infos.values(component);
     infos.remove(component);
+    foreach (const WidgetFactoryContainer &container, containers) {
+        trackPending(container.priority, -1);
+    }
+    disconnect(component, &QQmlComponent::statusChanged, this, &WidgetFactoryPrivate::statusChanged);
+
+    for (int i = containers.count() - 1; i >= 0; --i) {
+        enqueue(containers.at(i));
+    }
+    scheduleQueue(0);
 }
 
-void WidgetFactoryPrivate::addWidget(QQmlComponent *component, WidgetContextInfo *widgetContextInfo,
-                                     QObject *parent)
+void WidgetFactoryPrivate::componentDestroyed(QObject *object)
 {
-    Q_Q(WidgetFactory);
+    // Evicted while still loading: pending widgets cannot be created anymore
+    compileTimers.remove(static_cast<QQmlComponent *>(object));
+    QList<WidgetFactoryContainer> containers = infos.values(static_cast<QQmlComponent *>(object));
+    infos.remove(static_cast<QQmlComponent *>(object));
+    foreach (const WidgetFactoryContainer &container, containers) {
+        trackPending(container.priority, -1);
+        WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, container.widgetContextInfo);
+        container.widgetContextInfo->setStatus(WidgetContextInfo::Null);
+    }
+    updatePendingCount();
+}
+
+// Components are compiled asynchronously, so the compile stage is measured
+// from the first request to the moment the component is ready.
+QQmlComponent * WidgetFactoryPrivate::component(const QUrl &url)
+{
+    if (cache->contains(url)) {
+        return cache->component(url);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QQmlComponent *component = cache->component(url);
+    compileTimers.insert(component, timer);
+    if (component->status() == QQmlComponent::Ready || component->status() == QQmlComponent::Error) {
+        recordCompile(component);
+    }
+    return component;
+}
+
+void WidgetFactoryPrivate::recordCompile(QQmlComponent *component)
+{
+    QHash<QQmlComponent *, QElapsedTimer>::iterator i = compileTimers.find(component);
+    if (i == compileTimers.end()) {
+        return;
+    }
+
+    statistics->record(component->url(), 0, WidgetCreationStatistics::Compile, i.value().nsecsElapsed());
+    compileTimers.erase(i);
+}
+
+void WidgetFactoryPrivate::enqueue(const WidgetFactoryContainer &container)
+{
+    queue.insert(WidgetFactoryQueueKey(container.priority, queueSequence++), container);
+    trackPending(container.priority, 1);
+    container.widgetContextInfo->setStatus(WidgetContextInfo::Loading);
+}
+
+void WidgetFactoryPrivate::scheduleQueue(int interval)
+{
+    if (!queueTimer.isActive()) {
+        queueTimer.start(interval, this);
+    }
+    updatePendingCount();
+}
+
+void WidgetFactoryPrivate::processQueue()
+{
+    WIDGET_TRACE("WidgetFactory::processQueue");
+    // Requests are handled by priority, within the incubation budget, so
+    // that widgets close to the viewport are created first, while the
+    // frames keep coming.
+    QElapsedTimer timer;
+    timer.start();
+    bool exhausted = false;
+
+    // When all incubators are busy, asynchronous requests wait for a free
+    // one, but synchronous requests behind them are still handled.
+    QMap<WidgetFactoryQueueKey, WidgetFactoryContainer>::iterator i = queue.begin();
+    while (i != queue.end()) {
+        if (i.value().asynchronous && incubators.count() >= MAXIMUM_INCUBATORS) {
+            ++i;
+            continue;
+        }
+
+        WidgetFactoryQueueKey key = i.key();
+        WidgetFactoryContainer container = i.value();
+        queue.erase(i);
+        trackPending(container.priority, -1);
+
+        // Like for incubators, the container went away while queued
+        if (container.asynchronous && container.parent.isNull()) {
+            WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, container.widgetContextInfo);
+            container.widgetContextInfo->setStatus(WidgetContextInfo::Null);
+            i = queue.upperBound(key);
+            continue;
+        }
+
+        // Evicted components are fetched again
+        if (!container.component) {
+            container.component = this->component(container.url);
+        }
+        QQmlComponent *component = container.component;
+        if (component->status() == QQmlComponent::Ready || component->status() == QQmlComponent::Error) {
+            addWidget(component, container);
+        } else {
+            if (!infos.contains(component)) {
+                connect(component, &QQmlComponent::statusChanged, this, &WidgetFactoryPrivate::statusChanged);
+                connect(component, &QObject::destroyed, this, &WidgetFactoryPrivate::componentDestroyed,
+                        Qt::UniqueConnection);
+            }
+            infos.insert(component, container);
+            trackPending(container.priority, 1);
+        }
+
+        if (timer.elapsed() >= incubationBudget) {
+            exhausted = true;
+            break;
+        }
+
+        // Creating a widget might have changed the queue
+        if (incubators.count() < MAXIMUM_INCUBATORS) {
+            i = queue.begin();
+        } else {
+            i = queue.upperBound(key);
+        }
+    }
+
+    queueTimer.stop();
+    if (!queue.isEmpty() && (exhausted || incubators.count() < MAXIMUM_INCUBATORS)) {
+        queueTimer.start(INCUBATION_INTERVAL, this);
+    }
+    updatePendingCount();
+}
+
+void WidgetFactoryPrivate::addWidget(QQmlComponent *component, const WidgetFactoryContainer &container)
+{
+    WIDGET_TRACE("WidgetFactory::addWidget");
+    WidgetContextInfo *widgetContextInfo = container.widgetContextInfo;
     if (component->status() == QQmlComponent::Error) {
         qWarning() << "Error creating a component" << component->errorString().trimmed().toLocal8Bit().data();
-        infos.remove(component);
-        component->deleteLater();
+        WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, widgetContextInfo);
+        widgetContextInfo->setStatus(WidgetContextInfo::Error);
+        // Do not keep broken components around, so that a fixed widget can be loaded again
+        cache->evict(component->url());
         return;
     }
 
     if (component->status() == QQmlComponent::Ready) {
+        if (container.asynchronous) {
+            incubateWidget(component, container);
+            return;
+        }
+
         QQmlContext *context = new QQmlContext(engine->rootContext(), widgetContextInfo);
         context->setContextProperty("widget", widgetContextInfo);
+        qint64 initialMemory = memoryAccounting->isEnabled() ? WidgetMemoryAccounting::residentMemory() : -1;
+        QElapsedTimer timer;
+        timer.start();
         QObject *widget = component->beginCreate(context);
-        QQuickItem *item = qobject_cast<QQuickItem *>(widget);
-        QQuickItem *parentItem = qobject_cast<QQuickItem *>(parent);
-        widget->setParent(parent);
-        if (item && parentItem) {
-            item->setParentItem(parentItem);
+        statistics->record(container.url, widgetContextInfo, WidgetCreationStatistics::BeginCreate,
+                           timer.nsecsElapsed());
+        if (!widget) {
+            qWarning() << "Error creating a widget" << component->errorString().trimmed().toLocal8Bit().data();
+            WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, widgetContextInfo);
+            widgetContextInfo->setStatus(WidgetContextInfo::Error);
+            delete context;
+            return;
         }
+
+        setParent(widget, container.parent);
+        timer.restart();
         component->completeCreate();
+        statistics->record(container.url, widgetContextInfo, WidgetCreationStatistics::CompleteCreate,
+                           timer.nsecsElapsed());
+        statistics->record(container.url, widgetContextInfo, WidgetCreationStatistics::Total,
+                           container.requestTimer.nsecsElapsed());
+        if (initialMemory >= 0) {
+            memoryAccounting->recordCreation(widgetContextInfo,
+                                             WidgetMemoryAccounting::residentMemory() - initialMemory);
+        }
+        widgetReady(widgetContextInfo, container.url, widget, context);
+    }
+}
+
+void WidgetFactoryPrivate::incubateWidget(QQmlComponent *component, const WidgetFactoryContainer &container)
+{
+    WIDGET_TRACE("WidgetFactory::incubateWidget");
+    WidgetIncubationController::install(engine, incubationBudget);
+
+    WidgetContextInfo *widgetContextInfo = container.widgetContextInfo;
+    QQmlContext *context = new QQmlContext(engine->rootContext(), widgetContextInfo);
+    context->setContextProperty("widget", widgetContextInfo);
+    WidgetIncubator *incubator = new WidgetIncubator(this, container.url, widgetContextInfo, container.parent,
+                                                     context);
+    incubator->priority = container.priority;
+    incubator->requestTimer = container.requestTimer;
+    incubator->incubationTimer.start();
+    if (memoryAccounting->isEnabled()) {
+        incubator->initialMemory = WidgetMemoryAccounting::residentMemory();
+    }
+    incubators.append(incubator);
+    trackPending(incubator->priority, 1);
+    widgetContextInfo->setStatus(WidgetContextInfo::Loading);
+
+    // Might finish synchronously, if the component is simple enough
+    component->create(*incubator, context);
+
+    // Measured creations are not spread over frames, otherwise the other
+    // incubations and everything done between frames would be counted too
+    if (incubator->initialMemory >= 0 && incubator->isLoading()) {
+        incubator->forceCompletion();
+    }
+}
 
-        emit q->widgetCreated(widgetContextInfo, widget);
-        component->deleteLater();
+void WidgetFactoryPrivate::incubatorFinished(WidgetIncubator *incubator)
+{
+    if (!incubators.removeOne(incubator)) {
+        return;
+    }
+    trackPending(incubator->priority, -1);
+
+    // Incubators cannot be deleted from their own statusChanged
+    finishedIncubators.append(incubator);
+    QMetaObject::invokeMethod(this, "deleteFinishedIncubators", Qt::QueuedConnection);
+
+    WidgetContextInfo *widgetContextInfo = incubator->widgetContextInfo;
+    if (incubator->isError()) {
+        qWarning() << "Error creating a widget" << incubator->errors();
+        WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, widgetContextInfo);
+        widgetContextInfo->setStatus(WidgetContextInfo::Error);
+        delete incubator->context;
+    } else if (incubator->parent.isNull()) {
+        // The container went away while incubating
+        delete incubator->object();
+        delete incubator->context;
+        WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, widgetContextInfo);
+        widgetContextInfo->setStatus(WidgetContextInfo::Null);
+    } else {
+        // Incubation is spread over several frames, this is not CPU time
+        statistics->record(incubator->url, widgetContextInfo, WidgetCreationStatistics::Incubate,
+                           incubator->incubationTimer.nsecsElapsed());
+        statistics->record(incubator->url, widgetContextInfo, WidgetCreationStatistics::Total,
+                           incubator->requestTimer.nsecsElapsed());
+        if (incubator->initialMemory >= 0) {
+            memoryAccounting->recordCreation(widgetContextInfo,
+                                             WidgetMemoryAccounting::residentMemory() - incubator->initialMemory);
+        }
+        widgetReady(widgetContextInfo, incubator->url, incubator->object(), incubator->context);
+    }
+
+    // A slot is available for the next queued widget
+    if (!queue.isEmpty()) {
+        scheduleQueue(0);
+    } else {
+        updatePendingCount();
+    }
+}
+
+void WidgetFactoryPrivate::widgetReady(WidgetContextInfo *widgetContextInfo, const QUrl &url, QObject *widget,
+                                       QQmlContext *context)
+{
+    Q_Q(WidgetFactory);
+    // The context lives as long as the widget, so that a widget can be
+    // released and created again for the same WidgetContextInfo.
+    context->setParent(widget);
+    WidgetFactoryWidget entry;
+    entry.widget = widget;
+    entry.context = context;
+    entry.url = url;
+    widgets.insert(widgetContextInfo, entry);
+    connect(widgetContextInfo, &QObject::destroyed, this, &WidgetFactoryPrivate::contextInfoDestroyed,
+            Qt::UniqueConnection);
+    WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, widgetContextInfo);
+    widgetContextInfo->setStatus(WidgetContextInfo::Ready);
+    emit q->widgetCreated(widgetContextInfo, widget);
+}
+
+// Recycled widgets can be kept in a pool, detached from the scene and bound
+// to an empty WidgetContextInfo. Creating a widget of the same source binds
+// a pooled instance to the new WidgetContextInfo, instead of building the
+// whole object tree again. Widgets with internal state can implement a
+// reset() function, that is called before they are reused.
+bool WidgetFactoryPrivate::reuseWidget(const WidgetFactoryContainer &container)
+{
+    WIDGET_TRACE("WidgetFactory::reuseWidget");
+    Q_Q(WidgetFactory);
+    for (int i = pool.count() - 1; i >= 0; --i) {
+        if (pool.at(i).url != container.url) {
+            continue;
+        }
+
+        WidgetFactoryWidget entry = pool.takeAt(i);
+        emit q->pooledCountChanged();
+        if (entry.widget.isNull() || entry.context.isNull()) {
+            continue;
+        }
+
+        QObject *widget = entry.widget.data();
+        entry.context->setContextProperty("widget", container.widgetContextInfo);
+        if (widget->metaObject()->indexOfMethod("reset()") != -1) {
+            QMetaObject::invokeMethod(widget, "reset");
+        }
+        setParent(widget, container.parent);
+        QQuickItem *item = qobject_cast<QQuickItem *>(widget);
+        if (item) {
+            item->setVisible(true);
+        }
+        widgetReady(container.widgetContextInfo, entry.url, widget, entry.context);
+        return true;
     }
+    return false;
 }
 
-WidgetFactory::WidgetFactory(QQmlEngine *engine, QObject *parent) :
+void WidgetFactoryPrivate::releaseWidget(WidgetContextInfo *widgetContextInfo, bool recycle)
+{
+    Q_Q(WidgetFactory);
+    q->cancel(widgetContextInfo);
+    WidgetFactoryWidget entry = widgets.take(widgetContextInfo);
+    if (entry.widget) {
+        // Only the widget goes away, its state is kept by WidgetContextInfo
+        QQuickItem *item = qobject_cast<QQuickItem *>(entry.widget.data());
+        if (item) {
+            item->setVisible(false);
+            item->setParentItem(0);
+        }
+
+        if (recycle && poolCapacity > 0 && entry.context) {
+            poolWidget(entry);
+        } else {
+            destroyWidget(entry.widget);
+        }
+    }
+    widgetContextInfo->setStatus(WidgetContextInfo::Null);
+}
+
+void WidgetFactoryPrivate::poolWidget(const WidgetFactoryWidget &widget)
+{
+    Q_Q(WidgetFactory);
+    // Pooled widgets are the first memory to give back
+    if (isLowOnMemory()) {
+        trimPool(0);
+        destroyWidget(widget.widget);
+        return;
+    }
+
+    if (!pooledContextInfo) {
+        pooledContextInfo = new WidgetContextInfo(this);
+    }
+
+    // Bindings on the released WidgetContextInfo, that is likely to be
+    // deleted, are moved to an empty one
+    widget.context->setContextProperty("widget", pooledContextInfo);
+    widget.widget->setParent(this);
+    pool.append(widget);
+    trimPool(poolCapacity);
+    emit q->pooledCountChanged();
+}
+
+void WidgetFactoryPrivate::trimPool(int capacity)
+{
+    Q_Q(WidgetFactory);
+    if (pool.count() <= capacity) {
+        return;
+    }
+
+    // The least recently released go first
+    while (pool.count() > capacity) {
+        WidgetFactoryWidget entry = pool.takeFirst();
+        if (entry.widget) {
+            destroyWidget(entry.widget);
+        }
+    }
+    emit q->pooledCountChanged();
+}
+
+// There is no memory pressure notification in Qt. When a limit is set, the
+// resident memory of the process is checked each time a widget is pooled.
+// Applications that get notified of memory pressure can call clearPool.
+bool WidgetFactoryPrivate::isLowOnMemory() const
+{
+    if (poolMemoryLimit <= 0) {
+        return false;
+    }
+
+    qint64 residentMemory = WidgetMemoryAccounting::residentMemory();
+    return residentMemory >= 0 && residentMemory > poolMemoryLimit;
+}
+
+void WidgetFactoryPrivate::applicationStateChanged(Qt::ApplicationState state)
+{
+    // There is no memory pressure notification, but the system is likely
+    // to reclaim memory from applications that are not in the foreground
+    if (state == Qt::ApplicationHidden || state == Qt::ApplicationSuspended) {
+        trimPool(0);
+    }
+}
+
+void WidgetFactoryPrivate::destroyWidget(QObject *widget)
+{
+    if (teardown) {
+        teardown->schedule(widget);
+    } else {
+        widget->deleteLater();
+    }
+}
+
+void WidgetFactoryPrivate::contextInfoDestroyed(QObject *object)
+{
+    widgets.remove(static_cast<WidgetContextInfo *>(object));
+}
+
+void WidgetFactoryPrivate::deleteFinishedIncubators()
+{
+    qDeleteAll(finishedIncubators);
+    finishedIncubators.clear();
+}
+
+// Requests are counted when they enter or leave the queue, the components
+// being loaded or the incubators, so that the counts are not computed again
+// each time a widget is created.
+void WidgetFactoryPrivate::trackPending(qreal priority, int delta)
+{
+    requestCount += delta;
+    if (isVisible(priority)) {
+        visibleRequestCount += delta;
+    }
+}
+
+void WidgetFactoryPrivate::updatePendingCount()
+{
+    Q_Q(WidgetFactory);
+    if (pendingCount != requestCount) {
+        pendingCount = requestCount;
+        emit q->pendingCountChanged();
+    }
+
+    if (visiblePendingCount != visibleRequestCount) {
+        visiblePendingCount = visibleRequestCount;
+        emit q->visiblePendingCountChanged();
+    }
+}
+
+bool WidgetFactoryPrivate::isVisible(qreal priority)
+{
+    return priority <= 0;
+}
+
+void WidgetFactoryPrivate::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == queueTimer.timerId()) {
+        processQueue();
+    }
+}
+
+void WidgetFactoryPrivate::setParent(QObject *widget, QObject *parent)
+{
+    QQuickItem *item = qobject_cast<QQuickItem *>(widget);
+    QQuickItem *parentItem = qobject_cast<QQuickItem *>(parent);
+    widget->setParent(parent);
+    if (item && parentItem) {
+        item->setParentItem(parentItem);
+    }
+}
+
+WidgetFactory::WidgetFactory(QQmlEngine *engine, WidgetComponentCache *cache, WidgetTeardownScheduler *teardown,
+                             QObject *parent) :
     QObject(parent), d_ptr(new WidgetFactoryPrivate(this))
 {
     Q_D(WidgetFactory);
     d->engine = engine;
+    d->cache = cache;
+    d->teardown = teardown;
+    d->statistics = new WidgetCreationStatistics(this);
+    d->memoryAccounting = new WidgetMemoryAccounting(this, this);
 }
 
 WidgetFactory::~WidgetFactory()
 {
 }
 
-const QJsonObject & WidgetFactory::widgetDescriptionJson() const
+WidgetComponentCache * WidgetFactory::componentCache() const
 {
     Q_D(const WidgetFactory);
-    return d->widgetDescription;
+    return d->cache;
 }
 
-QString WidgetFactory::widgetName() const
+WidgetCreationStatistics * WidgetFactory::statistics() const
 {
     Q_D(const WidgetFactory);
-    return d->widgetDescription.value(NAME_KEY).toString();
+    return d->statistics;
 }
 
-QString WidgetFactory::widgetDescription() const
+WidgetMemoryAccounting * WidgetFactory::memoryAccounting() const
 {
     Q_D(const WidgetFactory);
-    return d->widgetDescription.value(DESCRIPTION_KEY).toString();
+    return d->memoryAccounting;
 }
 
-QUrl WidgetFactory::widgetSource() const
+int WidgetFactory::incubationBudget() const
 {
     Q_D(const WidgetFactory);
-    if (d->widgetDescription.isEmpty()) {
-        return QUrl();
-    }
-
-    QDir dir (d->source);
-    QString file = dir.absoluteFilePath(WIDGET_FILE_NAME);
-    QUrl source;
-    if (file.startsWith(":")) {
-        file = file.mid(1);
-        source = QUrl(QString("qrc:/%1").arg(file));
-    } else if (file.startsWith("qrc:")) {
-        file = file.mid(4);
-        source = QUrl(QString("qrc:/%1").arg(file));
-    } else {
-        source = QUrl::fromLocalFile(file);
+    return d->incubationBudget;
+}
+
+void WidgetFactory::setIncubationBudget(int incubationBudget)
+{
+    Q_D(WidgetFactory);
+    d->incubationBudget = qMax(1, incubationBudget);
+}
+
+int WidgetFactory::pendingCount() const
+{
+    Q_D(const WidgetFactory);
+    return d->pendingCount;
+}
+
+int WidgetFactory::visiblePendingCount() const
+{
+    Q_D(const WidgetFactory);
+    return d->visiblePendingCount;
+}
+
+int WidgetFactory::poolCapacity() const
+{
+    Q_D(const WidgetFactory);
+    return d->poolCapacity;
+}
+
+void WidgetFactory::setPoolCapacity(int poolCapacity)
+{
+    Q_D(WidgetFactory);
+    d->poolCapacity = qMax(0, poolCapacity);
+    d->trimPool(d->poolCapacity);
+}
+
+int WidgetFactory::pooledCount() const
+{
+    Q_D(const WidgetFactory);
+    return d->pool.count();
+}
+
+qint64 WidgetFactory::poolMemoryLimit() const
+{
+    Q_D(const WidgetFactory);
+    return d->poolMemoryLimit;
+}
+
+void WidgetFactory::setPoolMemoryLimit(qint64 poolMemoryLimit)
+{
+    Q_D(WidgetFactory);
+    d->poolMemoryLimit = qMax<qint64>(0, poolMemoryLimit);
+    if (d->isLowOnMemory()) {
+        d->trimPool(0);
     }
-    return source;
 }
 
-WidgetContextInfo * WidgetFactory::createWidgetContext(QObject *parent) const
+QObject * WidgetFactory::widget(WidgetContextInfo *widgetContextInfo) const
+{
+    Q_D(const WidgetFactory);
+    return d->widgets.value(widgetContextInfo).widget.data();
+}
+
+QUrl WidgetFactory::widgetSource(WidgetContextInfo *widgetContextInfo) const
+{
+    Q_D(const WidgetFactory);
+    return d->widgets.value(widgetContextInfo).url;
+}
+
+QList<WidgetContextInfo *> WidgetFactory::widgetContextInfos() const
 {
     Q_D(const WidgetFactory);
-    if (d->widgetDescription.isEmpty()) {
+    return d->widgets.keys();
+}
+
+// Used when a widget is unloaded, for example outside of the viewport: its
+// WidgetContextInfo stays, and it is likely to be created again for it.
+void WidgetFactory::release(WidgetContextInfo *widgetContextInfo)
+{
+    WIDGET_TRACE("WidgetFactory::release");
+    Q_D(WidgetFactory);
+    d->releaseWidget(widgetContextInfo, false);
+}
+
+// Used when a widget is removed from the dashboard: the widget is pooled,
+// to be reused when a widget of the same source is added.
+void WidgetFactory::recycle(WidgetContextInfo *widgetContextInfo)
+{
+    WIDGET_TRACE("WidgetFactory::recycle");
+    Q_D(WidgetFactory);
+    d->releaseWidget(widgetContextInfo, true);
+}
+
+void WidgetFactory::clearPool()
+{
+    Q_D(WidgetFactory);
+    d->trimPool(0);
+}
+
+void WidgetFactory::cancel(WidgetContextInfo *widgetContextInfo)
+{
+    Q_D(WidgetFactory);
+    bool cancelled = false;
+    QMap<WidgetFactoryQueueKey, WidgetFactoryContainer>::iterator j = d->queue.begin();
+    while (j != d->queue.end()) {
+        if (j.value().widgetContextInfo == widgetContextInfo) {
+            d->trackPending(j.value().priority, -1);
+            j = d->queue.erase(j);
+            cancelled = true;
+        } else {
+            ++j;
+        }
+    }
+
+    QMultiMap<QQmlComponent *, WidgetFactoryContainer>::iterator i = d->infos.begin();
+    while (i != d->infos.end()) {
+        if (i.value().widgetContextInfo == widgetContextInfo) {
+            d->trackPending(i.value().priority, -1);
+            i = d->infos.erase(i);
+            cancelled = true;
+        } else {
+            ++i;
+        }
+    }
+
+    foreach (WidgetIncubator *incubator, d->incubators) {
+        if (incubator->widgetContextInfo == widgetContextInfo) {
+            d->incubators.removeOne(incubator);
+            d->trackPending(incubator->priority, -1);
+            incubator->clear();
+            delete incubator->context;
+            delete incubator;
+            cancelled = true;
+        }
+    }
+
+    if (cancelled) {
+        WidgetTrace::asyncEnd(REQUEST_TRACE_NAME, widgetContextInfo);
+        widgetContextInfo->setStatus(WidgetContextInfo::Null);
+        d->updatePendingCount();
+    }
+}
+
+void WidgetFactory::setPriority(WidgetContextInfo *widgetContextInfo, qreal priority)
+{
+    Q_D(WidgetFactory);
+    QMap<WidgetFactoryQueueKey, WidgetFactoryContainer>::iterator j = d->queue.begin();
+    while (j != d->queue.end()) {
+        if (j.value().widgetContextInfo == widgetContextInfo) {
+            if (j.key().first == priority) {
+                return;
+            }
+            WidgetFactoryContainer container = j.value();
+            container.priority = priority;
+            d->trackPending(j.key().first, -1);
+            d->queue.erase(j);
+            d->queue.insert(WidgetFactoryQueueKey(priority, d->queueSequence++), container);
+            d->trackPending(priority, 1);
+            d->updatePendingCount();
+            return;
+        }
+        ++j;
+    }
+
+    // Already being loaded or incubated: only the bookkeeping changes
+    QMultiMap<QQmlComponent *, WidgetFactoryContainer>::iterator i = d->infos.begin();
+    while (i != d->infos.end()) {
+        if (i.value().widgetContextInfo == widgetContextInfo) {
+            d->trackPending(i.value().priority, -1);
+            d->trackPending(priority, 1);
+            i.value().priority = priority;
+        }
+        ++i;
+    }
+
+    foreach (WidgetIncubator *incubator, d->incubators) {
+        if (incubator->widgetContextInfo == widgetContextInfo) {
+            d->trackPending(incubator->priority, -1);
+            d->trackPending(priority, 1);
+            incubator->priority = priority;
+        }
+    }
+    d->updatePendingCount();
+}
+
+WidgetContextInfo * WidgetFactory::createWidgetContext(const WidgetManifest &manifest, QObject *parent) const
+{
+    if (!manifest.isValid()) {
         return 0;
     }
 
     // Get default size
-    QJsonObject defaultSettingsValue = d->widgetDescription.value(DEFAULT_SETTINGS_KEY).toObject();
-    QString sizeString = defaultSettingsValue.value(SIZE_KEY).toString();
+    QVariantMap defaultSettings = manifest.defaultSettings();
+    QString sizeString = defaultSettings.value(SIZE_KEY).toString();
     WidgetContextInfo::WidgetSize size = WidgetContextInfo::Medium;
     if (sizeString == SIZE_SMALL) {
         size = WidgetContextInfo::Small;
@@ -197,53 +987,44 @@ WidgetContextInfo * WidgetFactory::createWidgetContext(QObject *parent) const
     }
 
     WidgetContextInfo *context = WidgetContextInfo::create(size, parent);
+    context->setDefaultSettings(defaultSettings);
     return context;
 }
 
-bool WidgetFactory::readSource(const QString &source)
+void WidgetFactory::createWidget(const QUrl &url, WidgetContextInfo *widgetContextInfo, QObject *parent,
+                                 bool asynchronous, qreal priority)
 {
+    WIDGET_TRACE("WidgetFactory::createWidget");
     Q_D(WidgetFactory);
-    d->widgetDescription = QJsonObject();
-    QDir subdir (source);
+    cancel(widgetContextInfo);
 
-    // Check widget description file inside dir
-    QString fileName = subdir.absoluteFilePath(WIDGET_DESCRIPTION_FILE);
-    if (!QFile::exists(fileName)) {
-        return false;
-    }
+    WidgetFactoryContainer container;
+    container.url = url;
+    container.widgetContextInfo = widgetContextInfo;
+    container.parent = parent;
+    container.asynchronous = asynchronous;
+    container.priority = priority;
+    container.requestTimer.start();
+    WidgetTrace::asyncBegin(REQUEST_TRACE_NAME, widgetContextInfo);
 
-    QFile file (fileName);
-    if (!file.open(QIODevice::ReadOnly)) {
-        return false;
+    if (parent && d->reuseWidget(container)) {
+        return;
     }
-    QJsonParseError error;
-    QJsonDocument widgetDescriptionDocument = QJsonDocument::fromJson(file.readAll(), &error);
-    file.close();
 
-    if (error.error != QJsonParseError::NoError) {
-        qWarning() << "Error parsing widget description file:"
-                   << error.errorString().toLocal8Bit().data();
-        return false;
+    // Synchronous creation is done right away if possible, as expected by
+    // the caller. Everything else goes through the queue.
+    if (!asynchronous) {
+        QQmlComponent *component = d->component(url);
+        if (component->status() == QQmlComponent::Ready || component->status() == QQmlComponent::Error) {
+            d->addWidget(component, container);
+            d->updatePendingCount();
+            return;
+        }
+        container.component = component;
     }
 
-    d->source = source;
-    d->widgetDescription = widgetDescriptionDocument.object();
-    return true;
-}
-
-void WidgetFactory::createWidget(const QUrl &url, WidgetContextInfo *widgetContextInfo, QObject *parent)
-{
-    Q_D(WidgetFactory);
-    QQmlComponent *component = new QQmlComponent(d->engine, url, QQmlComponent::Asynchronous, this);
-    if (component->status() == QQmlComponent::Ready || component->status() == QQmlComponent::Error) {
-        d->addWidget(component, widgetContextInfo, parent);
-    } else {
-        connect(component, &QQmlComponent::statusChanged, d, &WidgetFactoryPrivate::statusChanged);
-        WidgetFactoryContainer container;
-        container.widgetContextInfo = widgetContextInfo;
-        container.parent = parent;
-        d->infos.insert(component, container);
-    }
+    d->enqueue(container);
+    d->scheduleQueue(0);
 }
 
 
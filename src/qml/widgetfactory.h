@@ -32,30 +32,55 @@
 #ifndef WIDGETFACTORY_H
 #define WIDGETFACTORY_H
 
+#include <QtCore/QList>
 #include <QtCore/QObject>
 
-class QJsonObject;
 class QUrl;
 class QQmlComponent;
 class QQmlEngine;
+class WidgetComponentCache;
 class WidgetContextInfo;
+class WidgetCreationStatistics;
+class WidgetManifest;
+class WidgetMemoryAccounting;
+class WidgetTeardownScheduler;
 struct WidgetFactoryContainer;
 class WidgetFactoryPrivate;
 class WidgetFactory : public QObject
 {
     Q_OBJECT
 public:
-    explicit WidgetFactory(QQmlEngine *engine, QObject *parent = 0);
+    explicit WidgetFactory(QQmlEngine *engine, WidgetComponentCache *cache, WidgetTeardownScheduler *teardown,
+                           QObject *parent = 0);
     virtual ~WidgetFactory();
-    const QJsonObject & widgetDescriptionJson() const;
-    QString widgetName() const;
-    QString widgetDescription() const;
-    QUrl widgetSource() const;
-    WidgetContextInfo * createWidgetContext(QObject *parent = 0) const;
-    bool readSource(const QString &source);
-    void createWidget(const QUrl &url, WidgetContextInfo *widgetContextInfo, QObject *parent = 0);
+    WidgetComponentCache * componentCache() const;
+    WidgetCreationStatistics * statistics() const;
+    WidgetMemoryAccounting * memoryAccounting() const;
+    int incubationBudget() const;
+    void setIncubationBudget(int incubationBudget);
+    int pendingCount() const;
+    int visiblePendingCount() const;
+    int poolCapacity() const;
+    void setPoolCapacity(int poolCapacity);
+    int pooledCount() const;
+    qint64 poolMemoryLimit() const;
+    void setPoolMemoryLimit(qint64 poolMemoryLimit);
+    WidgetContextInfo * createWidgetContext(const WidgetManifest &manifest, QObject *parent = 0) const;
+    void createWidget(const QUrl &url, WidgetContextInfo *widgetContextInfo, QObject *parent = 0,
+                      bool asynchronous = false, qreal priority = 0);
+    void setPriority(WidgetContextInfo *widgetContextInfo, qreal priority);
+    void cancel(WidgetContextInfo *widgetContextInfo);
+    QObject * widget(WidgetContextInfo *widgetContextInfo) const;
+    QUrl widgetSource(WidgetContextInfo *widgetContextInfo) const;
+    QList<WidgetContextInfo *> widgetContextInfos() const;
+    void release(WidgetContextInfo *widgetContextInfo);
+    void recycle(WidgetContextInfo *widgetContextInfo);
+    void clearPool();
 signals:
     void widgetCreated(WidgetContextInfo *widgetContextInfo, QObject *widget);
+    void pendingCountChanged();
+    void visiblePendingCountChanged();
+    void pooledCountChanged();
 protected:
     QScopedPointer<WidgetFactoryPrivate> d_ptr;
 private:
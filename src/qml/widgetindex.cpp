@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetindex.h"
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QSaveFile>
+
+static const char *INDEX_SUFFIX = ".index";
+static const quint32 INDEX_MAGIC = 0x44425749; // DBWI
+static const quint32 INDEX_VERSION = 2;
+
+// Layout of the index, written with QDataStream:
+// magic, version, directory mtime (msecs since epoch), package count, then
+// for each package: the whole widget.json, in the binary JSON format of
+// QJsonDocument, that is loaded without parsing, the package directory
+// relative to the widgets directory, as UTF-8, and widget.json mtime (msecs
+// since epoch). Manifests loaded from the index are the same as the ones
+// read from the packages.
+
+WidgetIndex::WidgetIndex()
+    : m_valid(false)
+{
+}
+
+QString WidgetIndex::indexPath(const QString &path)
+{
+    // Stored next to the directory and not inside, so that writing it does
+    // not change the directory mtime used to check freshness.
+    QString cleanPath = QDir::cleanPath(QDir(path).absolutePath());
+    return cleanPath + QLatin1String(INDEX_SUFFIX);
+}
+
+bool WidgetIndex::write(const QString &path, const QString &indexPath)
+{
+    QDir dir (path);
+    if (!dir.exists()) {
+        qWarning() << "Widgets directory" << path << "does not exist";
+        return false;
+    }
+
+    QDateTime lastModified = QFileInfo(dir.absolutePath()).lastModified();
+    QList<WidgetManifest> manifests;
+    QStringList subdirs = dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    foreach (const QString &subdirPaths, subdirs) {
+        QDir subdir (path);
+        if (!subdir.cd(subdirPaths)) {
+            continue;
+        }
+
+        WidgetManifest manifest = WidgetManifest::read(subdir.absolutePath());
+        if (manifest.isValid()) {
+            manifests.append(manifest);
+        }
+    }
+
+    QSaveFile file (indexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot open" << indexPath << file.errorString().toLocal8Bit().data();
+        return false;
+    }
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << INDEX_MAGIC << INDEX_VERSION << lastModified.toMSecsSinceEpoch()
+           << static_cast<quint32>(manifests.count());
+    foreach (const WidgetManifest &manifest, manifests) {
+        stream << QJsonDocument(manifest.json()).toBinaryData()
+               << dir.relativeFilePath(manifest.source()).toUtf8()
+               << manifest.lastModified().toMSecsSinceEpoch();
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Cannot write" << indexPath << file.errorString().toLocal8Bit().data();
+        return false;
+    }
+    return true;
+}
+
+WidgetIndex WidgetIndex::read(const QString &path)
+{
+    WidgetIndex index;
+    QFile file (indexPath(path));
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return index;
+    }
+
+    // Mapped rather than read into a buffer, which saves a copy of the file.
+    // Entries are still all converted to manifests below.
+    qint64 size = file.size();
+    uchar *data = file.map(0, size);
+    if (!data) {
+        return index;
+    }
+
+    QByteArray rawData = QByteArray::fromRawData(reinterpret_cast<const char *>(data), size);
+    QDataStream stream (rawData);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 lastModified = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> lastModified >> count;
+    QDateTime dirLastModified = QFileInfo(path).lastModified();
+    if (stream.status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION
+        || dirLastModified.toMSecsSinceEpoch() != lastModified) {
+        file.unmap(data);
+        return index;
+    }
+
+    QDir dir (path);
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QByteArray json;
+        QByteArray source;
+        qint64 manifestLastModified = 0;
+        stream >> json >> source >> manifestLastModified;
+
+        QJsonDocument document = QJsonDocument::fromBinaryData(json);
+        if (!document.isObject()) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+        QString absoluteSource = QDir::cleanPath(dir.absoluteFilePath(QString::fromUtf8(source)));
+        index.m_manifests.append(WidgetManifest(absoluteSource, document.object(),
+                                                QDateTime::fromMSecsSinceEpoch(manifestLastModified)));
+    }
+    file.unmap(data);
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Corrupted widget index" << file.fileName();
+        index.m_manifests.clear();
+        return index;
+    }
+
+    index.m_valid = true;
+    index.m_lastModified = dirLastModified;
+    return index;
+}
+
+bool WidgetIndex::isValid() const
+{
+    return m_valid;
+}
+
+QDateTime WidgetIndex::lastModified() const
+{
+    return m_lastModified;
+}
+
+QList<WidgetManifest> WidgetIndex::manifests() const
+{
+    return m_manifests;
+}
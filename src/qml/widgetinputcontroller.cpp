@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetinputcontroller.h"
+#include <QtCore/QBasicTimer>
+#include <QtCore/QPointer>
+#include <QtCore/QTimerEvent>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QStyleHints>
+
+// Same as MouseArea
+static const int PRESS_AND_HOLD_DELAY = 800;
+
+class WidgetInputControllerPrivate
+{
+public:
+    explicit WidgetInputControllerPrivate(WidgetInputController *q);
+    QQuickItem * itemAt(const QPointF &position) const;
+    void setDragItem(QQuickItem *item);
+    void reset();
+    QPointer<WidgetLayout> layout;
+    QPointer<QQuickItem> pressedItem;
+    QPointer<QQuickItem> dragItem;
+    QPointF pressPosition;
+    QPointF position;
+    QBasicTimer pressAndHoldTimer;
+    qreal dragThreshold;
+    bool clickCancelled;
+    bool movePending;
+protected:
+    WidgetInputController * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetInputController)
+};
+
+WidgetInputControllerPrivate::WidgetInputControllerPrivate(WidgetInputController *q)
+    : dragThreshold(qApp->styleHints()->startDragDistance()), clickCancelled(false), movePending(false)
+    , q_ptr(q)
+{
+}
+
+QQuickItem * WidgetInputControllerPrivate::itemAt(const QPointF &position) const
+{
+    Q_Q(const WidgetInputController);
+    if (!layout) {
+        return 0;
+    }
+
+    QPointF layoutPosition = q->mapToItem(layout, position);
+    return layout->itemAt(layout->indexAt(layoutPosition.x(), layoutPosition.y()));
+}
+
+void WidgetInputControllerPrivate::setDragItem(QQuickItem *item)
+{
+    Q_Q(WidgetInputController);
+    if (dragItem != item) {
+        dragItem = item;
+        emit q->dragItemChanged();
+    }
+}
+
+void WidgetInputControllerPrivate::reset()
+{
+    Q_Q(WidgetInputController);
+    pressAndHoldTimer.stop();
+    pressedItem = 0;
+    clickCancelled = false;
+    movePending = false;
+    setDragItem(0);
+    q->setKeepMouseGrab(false);
+}
+
+WidgetInputController::WidgetInputController(QQuickItem *parent) :
+    QQuickItem(parent), d_ptr(new WidgetInputControllerPrivate(this))
+{
+    setAcceptedMouseButtons(Qt::LeftButton);
+}
+
+WidgetInputController::~WidgetInputController()
+{
+}
+
+WidgetLayout * WidgetInputController::layout() const
+{
+    Q_D(const WidgetInputController);
+    return d->layout;
+}
+
+void WidgetInputController::setLayout(WidgetLayout *layout)
+{
+    Q_D(WidgetInputController);
+    if (d->layout != layout) {
+        d->layout = layout;
+        emit layoutChanged();
+    }
+}
+
+qreal WidgetInputController::dragThreshold() const
+{
+    Q_D(const WidgetInputController);
+    return d->dragThreshold;
+}
+
+void WidgetInputController::setDragThreshold(qreal dragThreshold)
+{
+    Q_D(WidgetInputController);
+    if (d->dragThreshold != dragThreshold) {
+        d->dragThreshold = dragThreshold;
+        emit dragThresholdChanged();
+    }
+}
+
+QQuickItem * WidgetInputController::dragItem() const
+{
+    Q_D(const WidgetInputController);
+    return d->dragItem;
+}
+
+void WidgetInputController::mousePressEvent(QMouseEvent *event)
+{
+    Q_D(WidgetInputController);
+    QQuickItem *item = d->itemAt(event->localPos());
+    if (!item) {
+        // Let the Flickable below handle it
+        event->ignore();
+        return;
+    }
+
+    d->reset();
+    d->pressedItem = item;
+    d->pressPosition = event->localPos();
+    d->position = event->localPos();
+    d->pressAndHoldTimer.start(PRESS_AND_HOLD_DELAY, this);
+    // The grab is only kept once a drag or a press and hold started, until
+    // then the Flickable below can steal it to scroll the dashboard
+    event->accept();
+}
+
+void WidgetInputController::mouseMoveEvent(QMouseEvent *event)
+{
+    Q_D(WidgetInputController);
+    if (!d->pressedItem) {
+        return;
+    }
+
+    d->position = event->localPos();
+    if (!d->dragItem) {
+        QPointF delta = d->position - d->pressPosition;
+        if (qAbs(delta.x()) < d->dragThreshold && qAbs(delta.y()) < d->dragThreshold) {
+            return;
+        }
+
+        d->pressAndHoldTimer.stop();
+        // Widgets are moved instead of flicking the dashboard
+        setKeepMouseGrab(true);
+        d->setDragItem(d->pressedItem);
+        emit dragStarted(d->dragItem, d->pressPosition.x(), d->pressPosition.y());
+    }
+
+    // Moves are delivered once per frame, whatever the event rate is
+    d->movePending = true;
+    polish();
+}
+
+void WidgetInputController::mouseReleaseEvent(QMouseEvent *event)
+{
+    Q_D(WidgetInputController);
+    Q_UNUSED(event)
+    QPointer<QQuickItem> item = d->pressedItem;
+    if (!item) {
+        return;
+    }
+
+    if (d->dragItem) {
+        if (d->movePending) {
+            emit dragMoved(item, d->position.x(), d->position.y());
+        }
+        d->reset();
+        emit dragFinished(item);
+    } else {
+        bool clickCancelled = d->clickCancelled;
+        d->reset();
+        if (!clickCancelled) {
+            emit clicked(item);
+        }
+    }
+}
+
+void WidgetInputController::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_D(WidgetInputController);
+    QQuickItem *item = d->itemAt(event->localPos());
+    if (!item) {
+        event->ignore();
+        return;
+    }
+
+    // Like MouseArea, the second release is not a click
+    d->clickCancelled = true;
+    emit doubleClicked(item);
+}
+
+void WidgetInputController::mouseUngrabEvent()
+{
+    Q_D(WidgetInputController);
+    QPointer<QQuickItem> item = d->dragItem;
+    d->reset();
+    if (item) {
+        emit dragFinished(item);
+    }
+}
+
+void WidgetInputController::timerEvent(QTimerEvent *event)
+{
+    Q_D(WidgetInputController);
+    if (event->timerId() == d->pressAndHoldTimer.timerId()) {
+        d->pressAndHoldTimer.stop();
+        if (d->pressedItem) {
+            setKeepMouseGrab(true);
+            d->clickCancelled = true;
+            emit pressAndHold(d->pressedItem);
+        }
+    }
+}
+
+void WidgetInputController::updatePolish()
+{
+    Q_D(WidgetInputController);
+    if (d->dragItem && d->movePending) {
+        d->movePending = false;
+        emit dragMoved(d->dragItem, d->position.x(), d->position.y());
+    }
+}
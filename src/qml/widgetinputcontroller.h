@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef WIDGETINPUTCONTROLLER_H
+#define WIDGETINPUTCONTROLLER_H
+
+#include <QtQuick/QQuickItem>
+#include "widgetlayout.h"
+
+class WidgetInputControllerPrivate;
+class WidgetInputController : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(WidgetLayout * layout READ layout WRITE setLayout NOTIFY layoutChanged)
+    Q_PROPERTY(qreal dragThreshold READ dragThreshold WRITE setDragThreshold NOTIFY dragThresholdChanged)
+    Q_PROPERTY(QQuickItem * dragItem READ dragItem NOTIFY dragItemChanged)
+public:
+    explicit WidgetInputController(QQuickItem *parent = 0);
+    virtual ~WidgetInputController();
+    WidgetLayout * layout() const;
+    void setLayout(WidgetLayout *layout);
+    qreal dragThreshold() const;
+    void setDragThreshold(qreal dragThreshold);
+    QQuickItem * dragItem() const;
+Q_SIGNALS:
+    void layoutChanged();
+    void dragThresholdChanged();
+    void dragItemChanged();
+    void clicked(QQuickItem *item);
+    void doubleClicked(QQuickItem *item);
+    void pressAndHold(QQuickItem *item);
+    void dragStarted(QQuickItem *item, qreal x, qreal y);
+    void dragMoved(QQuickItem *item, qreal x, qreal y);
+    void dragFinished(QQuickItem *item);
+protected:
+    void mousePressEvent(QMouseEvent *event);
+    void mouseMoveEvent(QMouseEvent *event);
+    void mouseReleaseEvent(QMouseEvent *event);
+    void mouseDoubleClickEvent(QMouseEvent *event);
+    void mouseUngrabEvent();
+    void timerEvent(QTimerEvent *event);
+    void updatePolish();
+    QScopedPointer<WidgetInputControllerPrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(WidgetInputController)
+};
+
+#endif // WIDGETINPUTCONTROLLER_H
@@ -0,0 +1,483 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetlayout.h"
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QVector>
+#include <QtQml/QQmlProperty>
+
+// Small widgets take one column, medium ones two and large ones the whole row
+static const int COLUMN_COUNT = 4;
+
+struct WidgetLayoutEntry
+{
+    WidgetContextInfo *contextInfo;
+    int span;
+    int column; // -1 if not laid out yet
+    qreal y;
+};
+
+static bool entryLessThan(const WidgetLayoutEntry &entry1, const WidgetLayoutEntry &entry2)
+{
+    return entry1.y < entry2.y;
+}
+
+class WidgetLayoutPrivate: public QObject
+{
+    Q_OBJECT
+public:
+    explicit WidgetLayoutPrivate(WidgetLayout *q);
+    static int span(WidgetContextInfo *contextInfo);
+    WidgetLayoutEntry entry(int row) const;
+    int indexOf(WidgetContextInfo *contextInfo) const;
+    void updateRows(int first, int last);
+    int rowStart(int index) const;
+    qreal itemHeight(WidgetContextInfo *contextInfo) const;
+    void reset();
+    void invalidate(int first, int last);
+    void relayout();
+    void placeItem(const WidgetLayoutEntry &entry, qreal columnWidth);
+    void updateHeight();
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsRemoved(const QModelIndex &parent, int first, int last);
+    void rowsMoved(const QModelIndex &parent, int start, int end, const QModelIndex &destination, int row);
+    void sizeChanged();
+    void itemHeightChanged();
+    void itemDestroyed(QObject *object);
+    QPointer<WidgetListModel> model;
+    QVector<WidgetLayoutEntry> entries;
+    QHash<WidgetContextInfo *, int> rows;
+    QHash<WidgetContextInfo *, QQuickItem *> items;
+    QHash<QQuickItem *, WidgetContextInfo *> contextInfos;
+    int dirtyFirst;
+    int dirtyLast;
+protected:
+    WidgetLayout * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetLayout)
+};
+
+WidgetLayoutPrivate::WidgetLayoutPrivate(WidgetLayout *q)
+    : dirtyFirst(-1), dirtyLast(-1), q_ptr(q)
+{
+}
+
+int WidgetLayoutPrivate::span(WidgetContextInfo *contextInfo)
+{
+    if (!contextInfo) {
+        return COLUMN_COUNT;
+    }
+
+    switch (contextInfo->size()) {
+    case WidgetContextInfo::Small:
+        return 1;
+        break;
+    case WidgetContextInfo::Medium:
+        return 2;
+        break;
+    default:
+        return COLUMN_COUNT;
+        break;
+    }
+}
+
+WidgetLayoutEntry WidgetLayoutPrivate::entry(int row) const
+{
+    WidgetLayoutEntry entry;
+    entry.contextInfo = model->data(model->index(row), WidgetListModel::ContextInfoRole).value<WidgetContextInfo *>();
+    entry.span = span(entry.contextInfo);
+    entry.column = -1;
+    entry.y = 0;
+    return entry;
+}
+
+int WidgetLayoutPrivate::indexOf(WidgetContextInfo *contextInfo) const
+{
+    return rows.value(contextInfo, -1);
+}
+
+// Size and height changes find their entry through the row map, so that
+// they do not cost a scan of the whole dashboard
+void WidgetLayoutPrivate::updateRows(int first, int last)
+{
+    for (int i = first; i <= last; ++i) {
+        WidgetContextInfo *contextInfo = entries.at(i).contextInfo;
+        if (contextInfo) {
+            rows.insert(contextInfo, i);
+        }
+    }
+}
+
+int WidgetLayoutPrivate::rowStart(int index) const
+{
+    // Only the entries that are laid out and start a row can be trusted
+    while (index > 0 && entries.at(index).column != 0) {
+        --index;
+    }
+    return index;
+}
+
+qreal WidgetLayoutPrivate::itemHeight(WidgetContextInfo *contextInfo) const
+{
+    QQuickItem *item = items.value(contextInfo, 0);
+    return item ? item->height() : 0;
+}
+
+void WidgetLayoutPrivate::reset()
+{
+    entries.clear();
+    rows.clear();
+    if (model) {
+        int count = model->rowCount();
+        entries.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            WidgetLayoutEntry newEntry = entry(i);
+            if (newEntry.contextInfo) {
+                connect(newEntry.contextInfo, &WidgetContextInfo::sizeChanged,
+                        this, &WidgetLayoutPrivate::sizeChanged, Qt::UniqueConnection);
+            }
+            entries.append(newEntry);
+        }
+    }
+    updateRows(0, entries.count() - 1);
+    dirtyFirst = -1;
+    dirtyLast = -1;
+    invalidate(0, entries.count() - 1);
+}
+
+void WidgetLayoutPrivate::invalidate(int first, int last)
+{
+    Q_Q(WidgetLayout);
+    first = qMax(0, qMin(first, entries.count() - 1));
+    dirtyFirst = dirtyFirst < 0 ? first : qMin(dirtyFirst, first);
+    dirtyLast = qMax(dirtyLast, last);
+    q->polish();
+}
+
+void WidgetLayoutPrivate::relayout()
+{
+    Q_Q(WidgetLayout);
+    if (dirtyFirst < 0) {
+        return;
+    }
+
+    if (entries.isEmpty()) {
+        dirtyFirst = -1;
+        dirtyLast = -1;
+        updateHeight();
+        return;
+    }
+
+    // Rows before the first change are kept, except the previous one, that
+    // a changed entry might join. Rows are then packed again until one
+    // starts at the same entry and position than before, after the last
+    // change: the following rows are left untouched.
+    qreal columnWidth = q->width() / COLUMN_COUNT;
+    int index = dirtyFirst > 0 ? rowStart(dirtyFirst - 1) : 0;
+    qreal y = index > 0 ? entries.at(index).y : 0;
+    qreal rowHeight = 0;
+    int column = 0;
+    for (int i = index; i < entries.count(); ++i) {
+        WidgetLayoutEntry &entry = entries[i];
+        if (column > 0 && column + entry.span > COLUMN_COUNT) {
+            y += rowHeight;
+            rowHeight = 0;
+            column = 0;
+        }
+
+        if (column == 0 && i > dirtyLast && entry.column == 0 && entry.y == y) {
+            break;
+        }
+
+        entry.column = column;
+        entry.y = y;
+        placeItem(entry, columnWidth);
+        rowHeight = qMax(rowHeight, itemHeight(entry.contextInfo));
+        column += entry.span;
+    }
+
+    dirtyFirst = -1;
+    dirtyLast = -1;
+    updateHeight();
+}
+
+void WidgetLayoutPrivate::placeItem(const WidgetLayoutEntry &entry, qreal columnWidth)
+{
+    QQuickItem *item = items.value(entry.contextInfo, 0);
+    if (!item) {
+        return;
+    }
+
+    item->setWidth(entry.span * columnWidth);
+    // Written as QML properties, so that a Behavior can animate the move
+    QQmlProperty::write(item, QLatin1String("x"), entry.column * columnWidth);
+    QQmlProperty::write(item, QLatin1String("y"), entry.y);
+}
+
+void WidgetLayoutPrivate::updateHeight()
+{
+    Q_Q(WidgetLayout);
+    if (entries.isEmpty()) {
+        q->setImplicitHeight(0);
+        return;
+    }
+
+    int index = rowStart(entries.count() - 1);
+    qreal rowHeight = 0;
+    for (int i = index; i < entries.count(); ++i) {
+        rowHeight = qMax(rowHeight, itemHeight(entries.at(i).contextInfo));
+    }
+    q->setImplicitHeight(entries.at(index).y + rowHeight);
+}
+
+void WidgetLayoutPrivate::rowsInserted(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    entries.insert(first, last - first + 1, WidgetLayoutEntry());
+    for (int i = first; i <= last; ++i) {
+        WidgetLayoutEntry newEntry = entry(i);
+        if (newEntry.contextInfo) {
+            connect(newEntry.contextInfo, &WidgetContextInfo::sizeChanged,
+                    this, &WidgetLayoutPrivate::sizeChanged, Qt::UniqueConnection);
+        }
+        entries[i] = newEntry;
+    }
+    updateRows(first, entries.count() - 1);
+    invalidate(first, last);
+}
+
+void WidgetLayoutPrivate::rowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    Q_UNUSED(parent)
+    // The model deletes the context infos later, they are still alive here
+    for (int i = first; i <= last; ++i) {
+        WidgetContextInfo *contextInfo = entries.at(i).contextInfo;
+        if (contextInfo) {
+            disconnect(contextInfo, &WidgetContextInfo::sizeChanged, this, &WidgetLayoutPrivate::sizeChanged);
+            rows.remove(contextInfo);
+        }
+    }
+    entries.remove(first, last - first + 1);
+    updateRows(first, entries.count() - 1);
+    invalidate(first - 1, first - 1);
+}
+
+void WidgetLayoutPrivate::rowsMoved(const QModelIndex &parent, int start, int end,
+                                    const QModelIndex &destination, int row)
+{
+    Q_UNUSED(parent)
+    Q_UNUSED(destination)
+    int count = end - start + 1;
+    int target = row > end ? row - count : row;
+    QVector<WidgetLayoutEntry> moved = entries.mid(start, count);
+    entries.remove(start, count);
+    for (int i = 0; i < count; ++i) {
+        entries.insert(target + i, moved.at(i));
+    }
+    updateRows(qMin(start, target), qMax(end, target + count - 1));
+    invalidate(qMin(start, target), qMax(end, target + count - 1));
+}
+
+void WidgetLayoutPrivate::sizeChanged()
+{
+    WidgetContextInfo *contextInfo = qobject_cast<WidgetContextInfo *>(sender());
+    int index = indexOf(contextInfo);
+    if (index == -1) {
+        return;
+    }
+
+    entries[index].span = span(contextInfo);
+    invalidate(index, index);
+}
+
+void WidgetLayoutPrivate::itemHeightChanged()
+{
+    QQuickItem *item = qobject_cast<QQuickItem *>(sender());
+    int index = indexOf(contextInfos.value(item, 0));
+    if (index != -1) {
+        invalidate(index, index);
+    }
+}
+
+void WidgetLayoutPrivate::itemDestroyed(QObject *object)
+{
+    // Only used as a key, the item is already gone
+    QQuickItem *item = static_cast<QQuickItem *>(object);
+    WidgetContextInfo *contextInfo = contextInfos.take(item);
+    if (items.value(contextInfo, 0) == item) {
+        items.remove(contextInfo);
+    }
+}
+
+WidgetLayout::WidgetLayout(QQuickItem *parent) :
+    QQuickItem(parent), d_ptr(new WidgetLayoutPrivate(this))
+{
+}
+
+WidgetLayout::~WidgetLayout()
+{
+}
+
+WidgetListModel * WidgetLayout::model() const
+{
+    Q_D(const WidgetLayout);
+    return d->model;
+}
+
+void WidgetLayout::setModel(WidgetListModel *model)
+{
+    Q_D(WidgetLayout);
+    if (d->model == model) {
+        return;
+    }
+
+    if (d->model) {
+        d->model->disconnect(d);
+    }
+
+    d->model = model;
+    if (model) {
+        connect(model, &QAbstractItemModel::rowsInserted, d, &WidgetLayoutPrivate::rowsInserted);
+        connect(model, &QAbstractItemModel::rowsRemoved, d, &WidgetLayoutPrivate::rowsRemoved);
+        connect(model, &QAbstractItemModel::rowsMoved, d, &WidgetLayoutPrivate::rowsMoved);
+        connect(model, &QAbstractItemModel::modelReset, d, &WidgetLayoutPrivate::reset);
+    }
+    d->reset();
+    emit modelChanged();
+}
+
+QRectF WidgetLayout::geometry(int index) const
+{
+    Q_D(const WidgetLayout);
+    if (index < 0 || index >= d->entries.count()) {
+        return QRectF();
+    }
+
+    const WidgetLayoutEntry &entry = d->entries.at(index);
+    qreal columnWidth = width() / COLUMN_COUNT;
+    return QRectF(qMax(entry.column, 0) * columnWidth, entry.y, entry.span * columnWidth,
+                  d->itemHeight(entry.contextInfo));
+}
+
+int WidgetLayout::indexAt(qreal x, qreal y) const
+{
+    Q_D(const WidgetLayout);
+    // Pending changes are applied first, so that entries are sorted
+    const_cast<WidgetLayoutPrivate *>(d)->relayout();
+
+    WidgetLayoutEntry probe;
+    probe.y = y;
+    QVector<WidgetLayoutEntry>::const_iterator next = qUpperBound(d->entries.constBegin(), d->entries.constEnd(),
+                                                                  probe, entryLessThan);
+    int index = next - d->entries.constBegin();
+    if (index == 0) {
+        return -1;
+    }
+
+    qreal columnWidth = width() / COLUMN_COUNT;
+    for (int i = d->rowStart(index - 1); i < index; ++i) {
+        const WidgetLayoutEntry &entry = d->entries.at(i);
+        if (x >= entry.column * columnWidth && x < (entry.column + entry.span) * columnWidth
+            && y < entry.y + d->itemHeight(entry.contextInfo)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+QQuickItem * WidgetLayout::itemAt(int index) const
+{
+    Q_D(const WidgetLayout);
+    if (index < 0 || index >= d->entries.count()) {
+        return 0;
+    }
+
+    return d->items.value(d->entries.at(index).contextInfo, 0);
+}
+
+void WidgetLayout::addItem(QQuickItem *item, WidgetContextInfo *contextInfo)
+{
+    Q_D(WidgetLayout);
+    if (!item || !contextInfo) {
+        return;
+    }
+
+    removeItem(item);
+    d->items.insert(contextInfo, item);
+    d->contextInfos.insert(item, contextInfo);
+    connect(item, &QQuickItem::heightChanged, d, &WidgetLayoutPrivate::itemHeightChanged);
+    connect(item, &QObject::destroyed, d, &WidgetLayoutPrivate::itemDestroyed);
+
+    int index = d->indexOf(contextInfo);
+    if (index != -1) {
+        d->invalidate(index, index);
+    }
+}
+
+void WidgetLayout::removeItem(QQuickItem *item)
+{
+    Q_D(WidgetLayout);
+    QHash<QQuickItem *, WidgetContextInfo *>::iterator i = d->contextInfos.find(item);
+    if (i == d->contextInfos.end()) {
+        return;
+    }
+
+    item->disconnect(d);
+    WidgetContextInfo *contextInfo = i.value();
+    d->contextInfos.erase(i);
+    if (d->items.value(contextInfo, 0) == item) {
+        d->items.remove(contextInfo);
+    }
+
+    int index = d->indexOf(contextInfo);
+    if (index != -1) {
+        d->invalidate(index, index);
+    }
+}
+
+void WidgetLayout::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    Q_D(WidgetLayout);
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    if (newGeometry.width() != oldGeometry.width()) {
+        // Every column moves
+        d->invalidate(0, d->entries.count() - 1);
+    }
+}
+
+void WidgetLayout::updatePolish()
+{
+    Q_D(WidgetLayout);
+    d->relayout();
+}
+
+#include "widgetlayout.moc"
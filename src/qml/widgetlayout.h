@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef WIDGETLAYOUT_H
+#define WIDGETLAYOUT_H
+
+#include <QtQuick/QQuickItem>
+#include "widgetcontextinfo.h"
+#include "widgetlistmodel.h"
+
+class WidgetLayoutPrivate;
+class WidgetLayout : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(WidgetListModel * model READ model WRITE setModel NOTIFY modelChanged)
+public:
+    explicit WidgetLayout(QQuickItem *parent = 0);
+    virtual ~WidgetLayout();
+    WidgetListModel * model() const;
+    void setModel(WidgetListModel *model);
+    Q_INVOKABLE QRectF geometry(int index) const;
+    Q_INVOKABLE int indexAt(qreal x, qreal y) const;
+    Q_INVOKABLE QQuickItem * itemAt(int index) const;
+public Q_SLOTS:
+    void addItem(QQuickItem *item, WidgetContextInfo *contextInfo);
+    void removeItem(QQuickItem *item);
+Q_SIGNALS:
+    void modelChanged();
+protected:
+    void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry);
+    void updatePolish();
+    QScopedPointer<WidgetLayoutPrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(WidgetLayout)
+};
+
+#endif // WIDGETLAYOUT_H
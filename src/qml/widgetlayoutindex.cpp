@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetlayoutindex.h"
+#include <QtCore/QBasicTimer>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QTimerEvent>
+#include <QtCore/QVector>
+#include <QtCore/qmath.h>
+#include <QtQml/QQmlProperty>
+#include <QtQuick/QQuickItem>
+
+// Items are ordered by row, then by column, like the positioners do
+typedef QPair<qreal, qreal> WidgetLayoutIndexKey;
+
+struct WidgetLayoutIndexEntry
+{
+    WidgetLayoutIndexKey key;
+    qreal width;
+    qreal height;
+    QQuickItem *item;
+};
+
+static bool entryLessThan(const WidgetLayoutIndexEntry &entry1, const WidgetLayoutIndexEntry &entry2)
+{
+    return entry1.key < entry2.key;
+}
+
+static bool rowLessThan(const WidgetLayoutIndexEntry &entry1, const WidgetLayoutIndexEntry &entry2)
+{
+    return entry1.key.first < entry2.key.first;
+}
+
+class WidgetLayoutIndexPrivate: public QObject
+{
+    Q_OBJECT
+public:
+    explicit WidgetLayoutIndexPrivate(WidgetLayoutIndex *q);
+    QVector<WidgetLayoutIndexEntry>::iterator find(QQuickItem *item);
+    void updateItem(QQuickItem *item);
+    void takeItem(QQuickItem *item);
+    void itemGeometryChanged();
+    void itemDestroyed(QObject *object);
+    QRectF viewportArea() const;
+    void updateViewportItem(QQuickItem *item);
+    void updateViewport();
+    static bool writeViewport(QQuickItem *item, const QRectF &rect, const QRectF &area, qreal margin);
+    QSet<QQuickItem *> tracked;
+    QHash<QQuickItem *, WidgetLayoutIndexKey> keys;
+    QVector<WidgetLayoutIndexEntry> entries;
+    qreal maximumHeight;
+    QPointer<QQuickItem> layout;
+    QPointer<QQuickItem> viewport;
+    qreal viewportMargin;
+    QSet<QQuickItem *> visibleItems;
+    QBasicTimer viewportTimer;
+public Q_SLOTS:
+    void scheduleViewportUpdate();
+protected:
+    void timerEvent(QTimerEvent *event);
+    WidgetLayoutIndex * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetLayoutIndex)
+};
+
+WidgetLayoutIndexPrivate::WidgetLayoutIndexPrivate(WidgetLayoutIndex *q)
+    : maximumHeight(0), viewportMargin(0), q_ptr(q)
+{
+}
+
+QVector<WidgetLayoutIndexEntry>::iterator WidgetLayoutIndexPrivate::find(QQuickItem *item)
+{
+    QHash<QQuickItem *, WidgetLayoutIndexKey>::const_iterator i = keys.constFind(item);
+    if (i == keys.constEnd()) {
+        return entries.end();
+    }
+
+    WidgetLayoutIndexEntry probe;
+    probe.key = i.value();
+    QVector<WidgetLayoutIndexEntry>::iterator entry = qLowerBound(entries.begin(), entries.end(), probe,
+                                                                  entryLessThan);
+    while (entry != entries.end() && entry->item != item) {
+        ++entry;
+    }
+    return entry;
+}
+
+// Entries are kept sorted, and a geometry change only moves the entry of
+// its item, so that an item that moves every frame, while animated or
+// dragged, does not cost a rebuild of the whole index.
+void WidgetLayoutIndexPrivate::updateItem(QQuickItem *item)
+{
+    // Empty items are not part of the layout
+    if (item->width() <= 0 || item->height() <= 0) {
+        takeItem(item);
+        return;
+    }
+
+    // Only grows, it bounds the search for the items in the viewport
+    maximumHeight = qMax(maximumHeight, item->height());
+    WidgetLayoutIndexKey key (item->y(), item->x());
+    QVector<WidgetLayoutIndexEntry>::iterator entry = find(item);
+    if (entry != entries.end() && entry->key == key) {
+        entry->width = item->width();
+        entry->height = item->height();
+        return;
+    }
+
+    takeItem(item);
+    WidgetLayoutIndexEntry newEntry;
+    newEntry.key = key;
+    newEntry.width = item->width();
+    newEntry.height = item->height();
+    newEntry.item = item;
+    entries.insert(qUpperBound(entries.begin(), entries.end(), newEntry, entryLessThan), newEntry);
+    keys.insert(item, key);
+}
+
+void WidgetLayoutIndexPrivate::takeItem(QQuickItem *item)
+{
+    QVector<WidgetLayoutIndexEntry>::iterator entry = find(item);
+    if (entry != entries.end()) {
+        entries.erase(entry);
+    }
+    keys.remove(item);
+}
+
+void WidgetLayoutIndexPrivate::itemGeometryChanged()
+{
+    QQuickItem *item = qobject_cast<QQuickItem *>(sender());
+    if (item && tracked.contains(item)) {
+        updateItem(item);
+        scheduleViewportUpdate();
+    }
+}
+
+void WidgetLayoutIndexPrivate::itemDestroyed(QObject *object)
+{
+    Q_Q(WidgetLayoutIndex);
+    // Only used as a key, the item is already gone
+    QQuickItem *item = static_cast<QQuickItem *>(object);
+    if (tracked.remove(item)) {
+        takeItem(item);
+        visibleItems.remove(item);
+        emit q->countChanged();
+    }
+}
+
+// The visible part of the viewport, in the coordinates of the layout
+QRectF WidgetLayoutIndexPrivate::viewportArea() const
+{
+    return viewport->mapRectToItem(layout, QRectF(0, 0, viewport->width(), viewport->height()));
+}
+
+// Containers expose viewportVisible and viewportDistance, that are set
+// here for all of them, instead of each of them following the viewport.
+bool WidgetLayoutIndexPrivate::writeViewport(QQuickItem *item, const QRectF &rect, const QRectF &area,
+                                             qreal margin)
+{
+    qreal dx = qMax<qreal>(0, qMax(area.left() - rect.right(), rect.left() - area.right()));
+    qreal dy = qMax<qreal>(0, qMax(area.top() - rect.bottom(), rect.top() - area.bottom()));
+    bool visible = dx <= margin && dy <= margin;
+    QQmlProperty::write(item, QLatin1String("viewportDistance"), qSqrt(dx * dx + dy * dy));
+    QQmlProperty::write(item, QLatin1String("viewportVisible"), visible);
+    return visible;
+}
+
+void WidgetLayoutIndexPrivate::updateViewportItem(QQuickItem *item)
+{
+    if (!layout || !viewport) {
+        QQmlProperty::write(item, QLatin1String("viewportDistance"), 0);
+        QQmlProperty::write(item, QLatin1String("viewportVisible"), true);
+        return;
+    }
+
+    QRectF rect (item->x(), item->y(), item->width(), item->height());
+    if (writeViewport(item, rect, viewportArea(), viewportMargin)) {
+        visibleItems.insert(item);
+    } else {
+        visibleItems.remove(item);
+    }
+}
+
+// Done once per frame at most. Only the items close to the viewport are
+// visited, using the order of the entries, and only the items that enter
+// or leave the viewport are updated, so that scrolling does not cost a
+// call for each widget of the dashboard.
+void WidgetLayoutIndexPrivate::updateViewport()
+{
+    if (!layout || !viewport) {
+        return;
+    }
+
+    QRectF area = viewportArea();
+    WidgetLayoutIndexEntry probe;
+    probe.key = WidgetLayoutIndexKey(area.top() - viewportMargin - maximumHeight, 0);
+    QVector<WidgetLayoutIndexEntry>::const_iterator first = qLowerBound(entries.constBegin(), entries.constEnd(),
+                                                                        probe, rowLessThan);
+    probe.key = WidgetLayoutIndexKey(area.bottom() + viewportMargin, 0);
+    QVector<WidgetLayoutIndexEntry>::const_iterator last = qUpperBound(first, entries.constEnd(), probe,
+                                                                       rowLessThan);
+
+    QSet<QQuickItem *> newVisibleItems;
+    for (QVector<WidgetLayoutIndexEntry>::const_iterator i = first; i != last; ++i) {
+        QRectF rect (i->key.second, i->key.first, i->width, i->height);
+        if (writeViewport(i->item, rect, area, viewportMargin)) {
+            newVisibleItems.insert(i->item);
+        }
+    }
+
+    // Items that left the area around the viewport
+    foreach (QQuickItem *item, visibleItems) {
+        if (!newVisibleItems.contains(item) && tracked.contains(item)) {
+            QRectF rect (item->x(), item->y(), item->width(), item->height());
+            writeViewport(item, rect, area, viewportMargin);
+        }
+    }
+    visibleItems = newVisibleItems;
+}
+
+void WidgetLayoutIndexPrivate::scheduleViewportUpdate()
+{
+    if (layout && viewport && !viewportTimer.isActive()) {
+        viewportTimer.start(0, this);
+    }
+}
+
+void WidgetLayoutIndexPrivate::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == viewportTimer.timerId()) {
+        viewportTimer.stop();
+        updateViewport();
+    }
+}
+
+WidgetLayoutIndex::WidgetLayoutIndex(QObject *parent) :
+    QObject(parent), d_ptr(new WidgetLayoutIndexPrivate(this))
+{
+}
+
+WidgetLayoutIndex::~WidgetLayoutIndex()
+{
+}
+
+int WidgetLayoutIndex::count() const
+{
+    Q_D(const WidgetLayoutIndex);
+    return d->tracked.count();
+}
+
+// The item that positions the indexed items. The viewport is mapped to its
+// coordinates to find the items that are visible.
+QQuickItem * WidgetLayoutIndex::layout() const
+{
+    Q_D(const WidgetLayoutIndex);
+    return d->layout;
+}
+
+void WidgetLayoutIndex::setLayout(QQuickItem *layout)
+{
+    Q_D(WidgetLayoutIndex);
+    if (d->layout != layout) {
+        if (d->layout) {
+            disconnect(d->layout, 0, d, 0);
+        }
+        d->layout = layout;
+        if (layout) {
+            connect(layout, &QQuickItem::xChanged, d, &WidgetLayoutIndexPrivate::scheduleViewportUpdate);
+            connect(layout, &QQuickItem::yChanged, d, &WidgetLayoutIndexPrivate::scheduleViewportUpdate);
+        }
+        d->scheduleViewportUpdate();
+        emit layoutChanged();
+    }
+}
+
+// Usually a Flickable: its content position is followed as well
+QQuickItem * WidgetLayoutIndex::viewport() const
+{
+    Q_D(const WidgetLayoutIndex);
+    return d->viewport;
+}
+
+void WidgetLayoutIndex::setViewport(QQuickItem *viewport)
+{
+    Q_D(WidgetLayoutIndex);
+    if (d->viewport != viewport) {
+        if (d->viewport) {
+            disconnect(d->viewport, 0, d, 0);
+        }
+        d->viewport = viewport;
+        if (viewport) {
+            connect(viewport, &QQuickItem::widthChanged, d, &WidgetLayoutIndexPrivate::scheduleViewportUpdate);
+            connect(viewport, &QQuickItem::heightChanged, d, &WidgetLayoutIndexPrivate::scheduleViewportUpdate);
+            QQmlProperty contentX (viewport, QLatin1String("contentX"));
+            contentX.connectNotifySignal(d, SLOT(scheduleViewportUpdate()));
+            QQmlProperty contentY (viewport, QLatin1String("contentY"));
+            contentY.connectNotifySignal(d, SLOT(scheduleViewportUpdate()));
+        }
+        d->scheduleViewportUpdate();
+        emit viewportChanged();
+    }
+}
+
+qreal WidgetLayoutIndex::viewportMargin() const
+{
+    Q_D(const WidgetLayoutIndex);
+    return d->viewportMargin;
+}
+
+void WidgetLayoutIndex::setViewportMargin(qreal viewportMargin)
+{
+    Q_D(WidgetLayoutIndex);
+    if (d->viewportMargin != viewportMargin) {
+        d->viewportMargin = viewportMargin;
+        d->scheduleViewportUpdate();
+        emit viewportMarginChanged();
+    }
+}
+
+int WidgetLayoutIndex::insertionIndex(qreal x, qreal y) const
+{
+    Q_D(const WidgetLayoutIndex);
+    const QVector<WidgetLayoutIndexEntry> &entries = d->entries;
+
+    // The row is the last one that starts above y. Items of the
+    // following rows come after the insertion index.
+    WidgetLayoutIndexEntry probe;
+    probe.key = WidgetLayoutIndexKey(y, x);
+    probe.width = 0;
+    probe.item = 0;
+    QVector<WidgetLayoutIndexEntry>::const_iterator next = qUpperBound(entries.constBegin(), entries.constEnd(),
+                                                                       probe, rowLessThan);
+    int lastIndex = next - entries.constBegin();
+    if (lastIndex == 0) {
+        return 0;
+    }
+
+    probe.key.first = entries.at(lastIndex - 1).key.first;
+    QVector<WidgetLayoutIndexEntry>::const_iterator row = qLowerBound(entries.constBegin(), next, probe,
+                                                                      rowLessThan);
+    int firstIndex = row - entries.constBegin();
+
+    // Then scan the row: on the left half of an item, the insertion index
+    // is before it, and after it on the right half.
+    for (int i = firstIndex; i < lastIndex; ++i) {
+        const WidgetLayoutIndexEntry &entry = entries.at(i);
+        qreal entryX = entry.key.second;
+        if (x < entryX + entry.width) {
+            return x < entryX + entry.width / 2 ? i : i + 1;
+        }
+    }
+    return lastIndex;
+}
+
+void WidgetLayoutIndex::addItem(QQuickItem *item)
+{
+    Q_D(WidgetLayoutIndex);
+    if (!item || d->tracked.contains(item)) {
+        return;
+    }
+
+    d->tracked.insert(item);
+    connect(item, &QQuickItem::xChanged, d, &WidgetLayoutIndexPrivate::itemGeometryChanged);
+    connect(item, &QQuickItem::yChanged, d, &WidgetLayoutIndexPrivate::itemGeometryChanged);
+    connect(item, &QQuickItem::widthChanged, d, &WidgetLayoutIndexPrivate::itemGeometryChanged);
+    connect(item, &QQuickItem::heightChanged, d, &WidgetLayoutIndexPrivate::itemGeometryChanged);
+    connect(item, &QObject::destroyed, d, &WidgetLayoutIndexPrivate::itemDestroyed);
+    d->updateItem(item);
+    d->updateViewportItem(item);
+    emit countChanged();
+}
+
+void WidgetLayoutIndex::removeItem(QQuickItem *item)
+{
+    Q_D(WidgetLayoutIndex);
+    if (!item || !d->tracked.remove(item)) {
+        return;
+    }
+
+    item->disconnect(d);
+    d->takeItem(item);
+    d->visibleItems.remove(item);
+    emit countChanged();
+}
+
+void WidgetLayoutIndex::clear()
+{
+    Q_D(WidgetLayoutIndex);
+    if (d->tracked.isEmpty()) {
+        return;
+    }
+
+    foreach (QQuickItem *item, d->tracked) {
+        item->disconnect(d);
+    }
+    d->tracked.clear();
+    d->keys.clear();
+    d->entries.clear();
+    d->visibleItems.clear();
+    d->maximumHeight = 0;
+    emit countChanged();
+}
+
+#include "widgetlayoutindex.moc"
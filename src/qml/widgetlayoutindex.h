@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef WIDGETLAYOUTINDEX_H
+#define WIDGETLAYOUTINDEX_H
+
+#include <QtCore/QObject>
+
+class QQuickItem;
+class WidgetLayoutIndexPrivate;
+class WidgetLayoutIndex : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(QQuickItem * layout READ layout WRITE setLayout NOTIFY layoutChanged)
+    Q_PROPERTY(QQuickItem * viewport READ viewport WRITE setViewport NOTIFY viewportChanged)
+    Q_PROPERTY(qreal viewportMargin READ viewportMargin WRITE setViewportMargin NOTIFY viewportMarginChanged)
+public:
+    explicit WidgetLayoutIndex(QObject *parent = 0);
+    virtual ~WidgetLayoutIndex();
+    int count() const;
+    QQuickItem * layout() const;
+    void setLayout(QQuickItem *layout);
+    QQuickItem * viewport() const;
+    void setViewport(QQuickItem *viewport);
+    qreal viewportMargin() const;
+    void setViewportMargin(qreal viewportMargin);
+    Q_INVOKABLE int insertionIndex(qreal x, qreal y) const;
+public Q_SLOTS:
+    void addItem(QQuickItem *item);
+    void removeItem(QQuickItem *item);
+    void clear();
+Q_SIGNALS:
+    void countChanged();
+    void layoutChanged();
+    void viewportChanged();
+    void viewportMarginChanged();
+protected:
+    QScopedPointer<WidgetLayoutIndexPrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(WidgetLayoutIndex)
+};
+
+#endif // WIDGETLAYOUTINDEX_H
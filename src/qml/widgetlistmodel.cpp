@@ -30,47 +30,184 @@
  */
 
 #include "widgetlistmodel.h"
+#include "dashboardservice.h"
 #include "widgetcontextinfo.h"
 #include "widgetfactory.h"
+#include "widgetmanifestregistry.h"
+#include "widgetteardownscheduler.h"
+#include "widgettrace.h"
+#include <QtCore/QBasicTimer>
+#include <QtCore/QDataStream>
 #include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QFutureWatcher>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QSaveFile>
+#include <QtCore/QSet>
+#include <QtCore/QTimerEvent>
 #include <QtCore/QUrl>
+#include <QtCore/QVector>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtQml/QQmlContext>
 #include <QtQml/QQmlEngine>
 
-struct WidgetListModelItem
+static const quint32 LAYOUT_MAGIC = 0x4442574c; // DBWL
+static const quint32 LAYOUT_VERSION = 1;
+// Changes are written at most once per second, and never from the GUI thread
+static const int SAVE_DELAY = 1000;
+// Changes that keep coming are still written after that delay
+static const int MAXIMUM_SAVE_DELAY = 5000;
+
+// Layout of the storage file, written with QDataStream:
+// magic, version, item count, then for each item: id, widget source,
+// size, settings and properties. Properties are updated by backends all
+// the time, so they are only written with layout and settings changes.
+
+struct WidgetListModelSavedItem
 {
-    virtual ~WidgetListModelItem();
-    QUrl source;
-    WidgetContextInfo *contextInfo;
+    qint32 id;
+    QString source;
+    qint32 size;
+    QVariantMap settings;
+    QVariantMap properties;
 };
 
-WidgetListModelItem::~WidgetListModelItem()
+static bool writeLayout(const QString &path, const QList<WidgetListModelSavedItem> &items)
 {
-    contextInfo->deleteLater();
+    WIDGET_TRACE("WidgetListModel::writeLayout");
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // Written to a temporary file, that replaces the previous one on commit
+    QSaveFile file (path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write dashboard layout" << path << file.errorString();
+        return false;
+    }
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << LAYOUT_MAGIC << LAYOUT_VERSION << (quint32) items.count();
+    foreach (const WidgetListModelSavedItem &item, items) {
+        stream << item.id << item.source << item.size << item.settings << item.properties;
+    }
+
+    if (stream.status() != QDataStream::Ok || !file.commit()) {
+        qWarning() << "Failed to write dashboard layout" << path;
+        return false;
+    }
+    return true;
 }
 
-class WidgetListModelPrivate
+static QList<WidgetListModelSavedItem> readLayout(const QString &path)
 {
+    WIDGET_TRACE("WidgetListModel::readLayout");
+    QList<WidgetListModelSavedItem> items;
+    QFile file (path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return items;
+    }
+
+    QDataStream stream (&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    stream >> magic >> version >> count;
+    if (magic != LAYOUT_MAGIC || version != LAYOUT_VERSION) {
+        qWarning() << "Ignoring invalid dashboard layout" << path;
+        return items;
+    }
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        WidgetListModelSavedItem item;
+        stream >> item.id >> item.source >> item.size >> item.settings >> item.properties;
+        items.append(item);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Ignoring truncated dashboard layout" << path;
+        items.clear();
+    }
+    return items;
+}
+
+// Stored by value in the model, the row order is kept separately
+struct WidgetListModelItem
+{
+    int id;
+    int row;
+    WidgetManifest manifest;
+    WidgetContextInfo *contextInfo;
+};
+
+class WidgetListModelPrivate: public QObject
+{
+    Q_OBJECT
 public:
     explicit WidgetListModelPrivate(WidgetListModel *q);
     virtual ~WidgetListModelPrivate();
     void init();
-    QList<WidgetListModelItem *> items;
-    WidgetFactory *factory;
+    WidgetListModelItem * item(int row);
+    const WidgetListModelItem * item(int row) const;
+    int createItem(const QString &source, int id = -1);
+    void releaseItem(int slot);
+    void insertItems(const QList<int> &newSlots);
+    void removeItems(int first, int last);
+    void moveItem(int sourceIndex, int destinationIndex);
+    void updateRows(int first, int last);
+    static QList<int> longestIncreasingSubsequence(const QList<int> &values);
+    QList<WidgetListModelSavedItem> savedItems() const;
+    void restore();
+    void scheduleSave();
+    void save();
+    void saveFinished();
+    // Items live in a single vector. Slots of removed items are reused,
+    // so adding and removing widgets does not allocate each time.
+    QVector<WidgetListModelItem> storage;
+    QVector<int> freeSlots;
+    QVector<int> rows;
+    QHash<int, int> slotsById;
+    int nextId;
+    QPointer<WidgetFactory> factory;
+    WidgetManifestRegistry *registry;
+    QPointer<WidgetTeardownScheduler> teardown;
+    bool asynchronous;
+    bool complete;
+    QString storageFile;
+    QBasicTimer saveTimer;
+    QElapsedTimer saveDeadline;
+    QFutureWatcher<bool> saveWatcher;
+    bool savePending;
 protected:
+    void timerEvent(QTimerEvent *event);
     WidgetListModel * const q_ptr;
 private:
     Q_DECLARE_PUBLIC(WidgetListModel)
 };
 
 WidgetListModelPrivate::WidgetListModelPrivate(WidgetListModel *q)
-    : factory(0), q_ptr(q)
+    : QObject(), nextId(0), factory(0), registry(0), asynchronous(false), complete(false)
+    , savePending(false), q_ptr(q)
 {
+    connect(&saveWatcher, &QFutureWatcherBase::finished, this, &WidgetListModelPrivate::saveFinished);
 }
 
 WidgetListModelPrivate::~WidgetListModelPrivate()
 {
-    qDeleteAll(items);
+    // Last changes are written right away, after the running write
+    saveWatcher.waitForFinished();
+    if (saveTimer.isActive() || savePending) {
+        writeLayout(storageFile, savedItems());
+    }
+
+    // The factory outlives the model, so pending creations must be dropped
+    foreach (int slot, rows) {
+        releaseItem(slot);
+    }
 }
 
 void WidgetListModelPrivate::init()
@@ -78,20 +215,258 @@ void WidgetListModelPrivate::init()
     Q_Q(WidgetListModel);
     QQmlContext *context = QQmlEngine::contextForObject(q);
     if (context) {
-        factory = new WidgetFactory(context->engine(), q);
+        // Shared by every model of the engine
+        DashboardService *service = DashboardService::instance(context->engine());
+        factory = service->factory();
+        registry = service->manifestRegistry();
+        teardown = service->teardown();
     } else {
         qWarning() << "Failed to initialize widget factory. No widget will be available.";
     }
 }
 
+WidgetListModelItem * WidgetListModelPrivate::item(int row)
+{
+    return &storage[rows.at(row)];
+}
+
+const WidgetListModelItem * WidgetListModelPrivate::item(int row) const
+{
+    return &storage.at(rows.at(row));
+}
+
+int WidgetListModelPrivate::createItem(const QString &source, int id)
+{
+    Q_Q(WidgetListModel);
+    // Usually already known from InstalledWidgetListModel
+    WidgetManifest manifest = registry->manifest(source);
+    if (!manifest.isValid()) {
+        return -1;
+    }
+
+    if (id < 0 || slotsById.contains(id)) {
+        id = nextId;
+    }
+    nextId = qMax(nextId, id + 1);
+
+    int slot;
+    if (!freeSlots.isEmpty()) {
+        slot = freeSlots.last();
+        freeSlots.removeLast();
+    } else {
+        slot = storage.count();
+        storage.resize(slot + 1);
+    }
+
+    WidgetListModelItem &item = storage[slot];
+    item.id = id;
+    item.manifest = manifest;
+    item.contextInfo = factory->createWidgetContext(manifest, q);
+    connect(item.contextInfo, &WidgetContextInfo::sizeChanged, this, &WidgetListModelPrivate::scheduleSave);
+    connect(item.contextInfo, &WidgetContextInfo::settingsChanged, this, &WidgetListModelPrivate::scheduleSave);
+    slotsById.insert(id, slot);
+    return slot;
+}
+
+void WidgetListModelPrivate::releaseItem(int slot)
+{
+    WidgetListModelItem &item = storage[slot];
+    // The widget might be kept by the factory, to be reused for a new item
+    if (factory) {
+        factory->recycle(item.contextInfo);
+    }
+    // Delegates might still use it until the end of the event loop. The
+    // scheduler also keeps it alive when the whole model is destroyed.
+    if (teardown) {
+        teardown->schedule(item.contextInfo);
+    } else {
+        item.contextInfo->deleteLater();
+    }
+    item.contextInfo = 0;
+    item.manifest = WidgetManifest();
+    slotsById.remove(item.id);
+    freeSlots.append(slot);
+}
+
+void WidgetListModelPrivate::insertItems(const QList<int> &newSlots)
+{
+    Q_Q(WidgetListModel);
+    if (newSlots.isEmpty()) {
+        return;
+    }
+
+    q->beginInsertRows(QModelIndex(), rows.count(), rows.count() + newSlots.count() - 1);
+    foreach (int slot, newSlots) {
+        storage[slot].row = rows.count();
+        rows.append(slot);
+    }
+    q->endInsertRows();
+    emit q->countChanged();
+}
+
+void WidgetListModelPrivate::removeItems(int first, int last)
+{
+    Q_Q(WidgetListModel);
+    q->beginRemoveRows(QModelIndex(), first, last);
+    for (int i = first; i <= last; ++i) {
+        releaseItem(rows.at(i));
+    }
+    rows.remove(first, last - first + 1);
+    updateRows(first, rows.count() - 1);
+    q->endRemoveRows();
+}
+
+void WidgetListModelPrivate::moveItem(int sourceIndex, int destinationIndex)
+{
+    Q_Q(WidgetListModel);
+    if (sourceIndex == destinationIndex) {
+        return;
+    }
+
+    // The destination for beginMoveRows is the row before which the item
+    // is inserted, counted before the item is taken out
+    int destinationChild = destinationIndex > sourceIndex ? destinationIndex + 1 : destinationIndex;
+    q->beginMoveRows(QModelIndex(), sourceIndex, sourceIndex, QModelIndex(), destinationChild);
+    int slot = rows.at(sourceIndex);
+    rows.remove(sourceIndex);
+    rows.insert(destinationIndex, slot);
+    updateRows(qMin(sourceIndex, destinationIndex), qMax(sourceIndex, destinationIndex));
+    q->endMoveRows();
+}
+
+// Each item knows its row, so that items are found by id in constant time
+void WidgetListModelPrivate::updateRows(int first, int last)
+{
+    for (int i = first; i <= last; ++i) {
+        storage[rows.at(i)].row = i;
+    }
+}
+
+QList<int> WidgetListModelPrivate::longestIncreasingSubsequence(const QList<int> &values)
+{
+    // Patience sorting: tails[k] is the index of the smallest tail of an
+    // increasing subsequence of length k + 1.
+    QList<int> tails;
+    QVector<int> previous (values.count(), -1);
+    for (int i = 0; i < values.count(); ++i) {
+        int value = values.at(i);
+        int low = 0;
+        int high = tails.count();
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (values.at(tails.at(middle)) < value) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+
+        if (low > 0) {
+            previous[i] = tails.at(low - 1);
+        }
+        if (low == tails.count()) {
+            tails.append(i);
+        } else {
+            tails[low] = i;
+        }
+    }
+
+    QList<int> subsequence;
+    int index = tails.isEmpty() ? -1 : tails.last();
+    while (index != -1) {
+        subsequence.prepend(index);
+        index = previous.at(index);
+    }
+    return subsequence;
+}
+
+QList<WidgetListModelSavedItem> WidgetListModelPrivate::savedItems() const
+{
+    QList<WidgetListModelSavedItem> savedItems;
+    foreach (int slot, rows) {
+        const WidgetListModelItem &item = storage.at(slot);
+        WidgetListModelSavedItem savedItem;
+        savedItem.id = item.id;
+        savedItem.source = item.manifest.source();
+        savedItem.size = item.contextInfo->size();
+        savedItem.settings = item.contextInfo->overriddenSettings();
+        savedItem.properties = item.contextInfo->properties();
+        savedItems.append(savedItem);
+    }
+    return savedItems;
+}
+
+void WidgetListModelPrivate::restore()
+{
+    WIDGET_TRACE("WidgetListModel::restore");
+    if (storageFile.isEmpty() || !factory || !registry) {
+        return;
+    }
+
+    QList<int> newSlots;
+    foreach (const WidgetListModelSavedItem &savedItem, readLayout(storageFile)) {
+        int slot = createItem(savedItem.source, savedItem.id);
+        if (slot == -1) {
+            continue;
+        }
+
+        WidgetContextInfo *contextInfo = storage.at(slot).contextInfo;
+        contextInfo->setSize((WidgetContextInfo::WidgetSize) savedItem.size);
+        contextInfo->setSettings(savedItem.settings);
+        contextInfo->setProperties(savedItem.properties);
+        newSlots.append(slot);
+    }
+    insertItems(newSlots);
+}
+
+void WidgetListModelPrivate::scheduleSave()
+{
+    if (!complete || storageFile.isEmpty()) {
+        return;
+    }
+
+    // Restarted on each change, so that a drag is written once, at the end,
+    // but not past the deadline, so that a crash does not lose everything
+    if (!saveTimer.isActive()) {
+        saveDeadline.start();
+    }
+    qint64 remaining = MAXIMUM_SAVE_DELAY - saveDeadline.elapsed();
+    saveTimer.start(qBound<qint64>(0, remaining, SAVE_DELAY), this);
+}
+
+void WidgetListModelPrivate::save()
+{
+    if (saveWatcher.isRunning()) {
+        savePending = true;
+        return;
+    }
+
+    saveWatcher.setFuture(QtConcurrent::run(writeLayout, storageFile, savedItems()));
+}
+
+void WidgetListModelPrivate::saveFinished()
+{
+    if (savePending) {
+        savePending = false;
+        save();
+    }
+}
+
+void WidgetListModelPrivate::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == saveTimer.timerId()) {
+        saveTimer.stop();
+        save();
+    }
+}
+
 WidgetListModel::WidgetListModel(QObject *parent)
     : QAbstractListModel(parent), d_ptr(new WidgetListModelPrivate(this))
 {
     Q_D(WidgetListModel);
-    QQmlContext *context = QQmlEngine::contextForObject(this);
-    if (context) {
-        d->factory = new WidgetFactory(context->engine(), this);
-    }
+    connect(this, &QAbstractItemModel::rowsInserted, d, &WidgetListModelPrivate::scheduleSave);
+    connect(this, &QAbstractItemModel::rowsRemoved, d, &WidgetListModelPrivate::scheduleSave);
+    connect(this, &QAbstractItemModel::rowsMoved, d, &WidgetListModelPrivate::scheduleSave);
 }
 
 
@@ -107,13 +482,15 @@ void WidgetListModel::componentComplete()
 {
     Q_D(WidgetListModel);
     d->init();
+    d->restore();
+    d->complete = true;
 }
 
 int WidgetListModel::rowCount(const QModelIndex &index) const
 {
     Q_UNUSED(index)
     Q_D(const WidgetListModel);
-    return d->items.count();
+    return d->rows.count();
 }
 
 QVariant WidgetListModel::data(const QModelIndex &index, int role) const
@@ -124,24 +501,134 @@ QVariant WidgetListModel::data(const QModelIndex &index, int role) const
         return QVariant();
     }
 
-    const WidgetListModelItem *item = d->items.at(row);
+    const WidgetListModelItem *item = d->item(row);
     switch (role) {
     case ContextInfoRole:
         return QVariant::fromValue(item->contextInfo);
         break;
+    case IdRole:
+        return item->id;
+        break;
     default:
         return QVariant();
         break;
     }
 }
 
+int WidgetListModel::idAt(int index) const
+{
+    Q_D(const WidgetListModel);
+    if (index < 0 || index >= rowCount()) {
+        return -1;
+    }
+
+    return d->item(index)->id;
+}
+
+int WidgetListModel::indexOf(int id) const
+{
+    Q_D(const WidgetListModel);
+    int slot = d->slotsById.value(id, -1);
+    if (slot == -1) {
+        return -1;
+    }
+    return d->storage.at(slot).row;
+}
+
+QList<int> WidgetListModel::ids() const
+{
+    Q_D(const WidgetListModel);
+    QList<int> ids;
+    foreach (int slot, d->rows) {
+        ids.append(d->storage.at(slot).id);
+    }
+    return ids;
+}
+
 int WidgetListModel::count() const
 {
     return rowCount();
 }
 
-void WidgetListModel::createWidget(int index, QObject *parent)
+bool WidgetListModel::isAsynchronous() const
+{
+    Q_D(const WidgetListModel);
+    return d->asynchronous;
+}
+
+void WidgetListModel::setAsynchronous(bool asynchronous)
+{
+    Q_D(WidgetListModel);
+    if (d->asynchronous != asynchronous) {
+        d->asynchronous = asynchronous;
+        emit asynchronousChanged();
+    }
+}
+
+QString WidgetListModel::storageFile() const
+{
+    Q_D(const WidgetListModel);
+    return d->storageFile;
+}
+
+void WidgetListModel::setStorageFile(const QString &storageFile)
+{
+    Q_D(WidgetListModel);
+    // The layout is restored when the component is completed
+    if (d->storageFile != storageFile) {
+        d->storageFile = storageFile;
+        emit storageFileChanged();
+    }
+}
+
+void WidgetListModel::createWidget(int index, QObject *parent, qreal priority)
+{
+    WIDGET_TRACE("WidgetListModel::createWidget");
+    Q_D(WidgetListModel);
+    if (index < 0 || index >= rowCount()) {
+        return;
+    }
+
+    if (!d->factory) {
+        return;
+    }
+
+    const WidgetListModelItem *item = d->item(index);
+    d->factory->createWidget(item->manifest.widgetSource(), item->contextInfo, parent, d->asynchronous,
+                             priority);
+}
+
+void WidgetListModel::setPriority(int index, qreal priority)
+{
+    Q_D(WidgetListModel);
+    if (index < 0 || index >= rowCount()) {
+        return;
+    }
+
+    if (!d->factory) {
+        return;
+    }
+
+    d->factory->setPriority(d->item(index)->contextInfo, priority);
+}
+
+void WidgetListModel::cancelCreation(int index)
+{
+    Q_D(WidgetListModel);
+    if (index < 0 || index >= rowCount()) {
+        return;
+    }
+
+    if (!d->factory) {
+        return;
+    }
+
+    d->factory->cancel(d->item(index)->contextInfo);
+}
+
+void WidgetListModel::releaseWidget(int index)
 {
+    WIDGET_TRACE("WidgetListModel::releaseWidget");
     Q_D(WidgetListModel);
     if (index < 0 || index >= rowCount()) {
         return;
@@ -151,29 +638,38 @@ void WidgetListModel::createWidget(int index, QObject *parent)
         return;
     }
 
-    const WidgetListModelItem *item = d->items.at(index);
-    d->factory->createWidget(item->source, item->contextInfo, parent);
+    d->factory->release(d->item(index)->contextInfo);
 }
 
 void WidgetListModel::add(const QString &source)
 {
+    WIDGET_TRACE("WidgetListModel::add");
+    addSources(QStringList() << source);
+}
+
+void WidgetListModel::addSources(const QStringList &sources)
+{
+    WIDGET_TRACE("WidgetListModel::addSources");
     Q_D(WidgetListModel);
-    if (!d->factory->readSource(source)) {
+    if (!d->factory || !d->registry) {
         return;
     }
 
-    beginInsertRows(QModelIndex(), rowCount(), rowCount());
+    QList<int> newSlots;
+    foreach (const QString &source, sources) {
+        int slot = d->createItem(source);
+        if (slot != -1) {
+            newSlots.append(slot);
+        }
+    }
 
-    WidgetListModelItem *item = new WidgetListModelItem;
-    item->source = d->factory->widgetSource();
-    item->contextInfo = d->factory->createWidgetContext(this);
-    d->items.append(item);
-    emit countChanged();
-    endInsertRows();
+    // Invalid sources are skipped, so the new rows are contiguous
+    d->insertItems(newSlots);
 }
 
 void WidgetListModel::move(int sourceIndex, int destinationIndex)
 {
+    WIDGET_TRACE("WidgetListModel::move");
     Q_D(WidgetListModel);
     if (!beginMoveRows(QModelIndex(), sourceIndex, sourceIndex, QModelIndex(), destinationIndex)) {
         return;
@@ -182,38 +678,142 @@ void WidgetListModel::move(int sourceIndex, int destinationIndex)
     if (newDestinationIndex > sourceIndex) {
         newDestinationIndex --;
     }
-    d->items.move(sourceIndex, newDestinationIndex);
+    int slot = d->rows.at(sourceIndex);
+    d->rows.remove(sourceIndex);
+    d->rows.insert(newDestinationIndex, slot);
+    d->updateRows(qMin(sourceIndex, newDestinationIndex), qMax(sourceIndex, newDestinationIndex));
     endMoveRows();
 }
 
+void WidgetListModel::applyOrder(const QList<int> &ids)
+{
+    WIDGET_TRACE("WidgetListModel::applyOrder");
+    Q_D(WidgetListModel);
+    // Target position of each item. Unknown ids are ignored, and items that
+    // are not listed keep their relative order after the listed ones.
+    QHash<int, int> targets;
+    foreach (int id, ids) {
+        if (d->slotsById.contains(id) && !targets.contains(id)) {
+            targets.insert(id, targets.count());
+        }
+    }
+
+    QList<int> positions;
+    QVector<int> slotsByTarget (d->rows.count());
+    int unlisted = targets.count();
+    foreach (int slot, d->rows) {
+        int id = d->storage.at(slot).id;
+        int target = targets.contains(id) ? targets.value(id) : unlisted++;
+        positions.append(target);
+        slotsByTarget[target] = slot;
+    }
+
+    // Items of the longest increasing subsequence of target positions are
+    // already in order and stay in place: only the others are moved, which
+    // is the minimal number of moves.
+    QSet<int> stable;
+    foreach (int index, WidgetListModelPrivate::longestIncreasingSubsequence(positions)) {
+        stable.insert(positions.at(index));
+    }
+
+    // Each moved item is put right after the item that precedes it in the
+    // target order. Those are already in order, so the result is sorted.
+    for (int target = 0; target < slotsByTarget.count(); ++target) {
+        if (stable.contains(target)) {
+            continue;
+        }
+
+        int sourceIndex = d->storage.at(slotsByTarget.at(target)).row;
+        int destinationIndex = target == 0 ? 0 : d->storage.at(slotsByTarget.at(target - 1)).row + 1;
+        if (destinationIndex > sourceIndex) {
+            --destinationIndex;
+        }
+        d->moveItem(sourceIndex, destinationIndex);
+    }
+}
+
 void WidgetListModel::remove(int index)
 {
+    WIDGET_TRACE("WidgetListModel::remove");
+    removeRange(index, 1);
+}
+
+void WidgetListModel::removeRange(int index, int count)
+{
+    WIDGET_TRACE("WidgetListModel::removeRange");
     Q_D(WidgetListModel);
-    if (index < 0 || index >= rowCount()) {
+    int first = qMax(index, 0);
+    int last = qMin(index + count, rowCount()) - 1;
+    if (first > last) {
         return;
     }
 
-    beginRemoveRows(QModelIndex(), index, index);
-
-    delete d->items.takeAt(index);
+    d->removeItems(first, last);
     emit countChanged();
-    endRemoveRows();
+}
+
+void WidgetListModel::removeIndexes(const QList<int> &indexes)
+{
+    WIDGET_TRACE("WidgetListModel::removeIndexes");
+    Q_D(WidgetListModel);
+    QList<int> sortedIndexes = indexes;
+    qSort(sortedIndexes);
+
+    // Contiguous runs are removed from the end, so that the indexes of
+    // the runs that are not removed yet are still valid.
+    bool removed = false;
+    int i = sortedIndexes.count() - 1;
+    while (i >= 0) {
+        int last = sortedIndexes.at(i);
+        int first = last;
+        --i;
+        while (i >= 0 && sortedIndexes.at(i) >= first - 1) {
+            first = qMin(first, sortedIndexes.at(i));
+            --i;
+        }
+
+        first = qMax(first, 0);
+        last = qMin(last, rowCount() - 1);
+        if (first <= last) {
+            d->removeItems(first, last);
+            removed = true;
+        }
+    }
+
+    if (removed) {
+        emit countChanged();
+    }
 }
 
 void WidgetListModel::setSize(int index, int size)
 {
+    WIDGET_TRACE("WidgetListModel::setSize");
     Q_D(WidgetListModel);
     if (index < 0 || index >= rowCount()) {
         return;
     }
 
-    WidgetListModelItem *item = d->items[index];
+    WidgetListModelItem *item = d->item(index);
     item->contextInfo->setSize((WidgetContextInfo::WidgetSize) size);
 }
 
+void WidgetListModel::setSizes(const QList<int> &indexes, const QList<int> &sizes)
+{
+    WIDGET_TRACE("WidgetListModel::setSizes");
+    // Sizes are not a role: they are notified by each WidgetContextInfo,
+    // and views like WidgetLayout coalesce them into a single relayout.
+    int count = qMin(indexes.count(), sizes.count());
+    for (int i = 0; i < count; ++i) {
+        setSize(indexes.at(i), sizes.at(i));
+    }
+}
+
 QHash<int, QByteArray> WidgetListModel::roleNames() const
 {
     QHash<int, QByteArray> roles;
     roles.insert(ContextInfoRole, "contextInfo");
+    roles.insert(IdRole, "widgetId");
     return roles;
 }
+
+#include "widgetlistmodel.moc"
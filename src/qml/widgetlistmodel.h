@@ -33,6 +33,7 @@
 #define WIDGETLISTMODEL_H
 
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QStringList>
 #include <QtQml/QQmlParserStatus>
 
 class QUrl;
@@ -44,9 +45,12 @@ class WidgetListModel : public QAbstractListModel, public QQmlParserStatus
     Q_OBJECT
     Q_INTERFACES(QQmlParserStatus)
     Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(bool asynchronous READ isAsynchronous WRITE setAsynchronous NOTIFY asynchronousChanged)
+    Q_PROPERTY(QString storageFile READ storageFile WRITE setStorageFile NOTIFY storageFileChanged)
 public:
     enum Roles {
-        ContextInfoRole
+        ContextInfoRole,
+        IdRole
     };
     explicit WidgetListModel(QObject *parent = 0);
     virtual ~WidgetListModel();
@@ -55,14 +59,31 @@ public:
     int rowCount(const QModelIndex &index = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role) const;
     int count() const;
+    bool isAsynchronous() const;
+    void setAsynchronous(bool asynchronous);
+    QString storageFile() const;
+    void setStorageFile(const QString &storageFile);
+    Q_INVOKABLE int idAt(int index) const;
+    Q_INVOKABLE int indexOf(int id) const;
+    Q_INVOKABLE QList<int> ids() const;
 public Q_SLOTS:
-    void createWidget(int index, QObject *parent = 0);
+    void createWidget(int index, QObject *parent = 0, qreal priority = 0);
+    void setPriority(int index, qreal priority);
+    void cancelCreation(int index);
+    void releaseWidget(int index);
     void add(const QString &source);
+    void addSources(const QStringList &sources);
     void move(int sourceIndex, int destinationIndex);
+    void applyOrder(const QList<int> &ids);
     void remove(int index);
+    void removeRange(int index, int count);
+    void removeIndexes(const QList<int> &indexes);
     void setSize(int index, int size);
+    void setSizes(const QList<int> &indexes, const QList<int> &sizes);
 Q_SIGNALS:
     void countChanged();
+    void asynchronousChanged();
+    void storageFileChanged();
 protected:
     QHash<int, QByteArray> roleNames() const;
     QScopedPointer<WidgetListModelPrivate> d_ptr;
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetmanifest.h"
+#include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonValue>
+#include <QtCore/QSharedData>
+#include "widgettrace.h"
+
+static const char *WIDGET_DESCRIPTION_FILE = "widget.json";
+static const char *WIDGET_FILE_NAME = "widget.qml";
+static const char *NAME_KEY = "name";
+static const char *DESCRIPTION_KEY = "description";
+static const char *DEFAULT_SETTINGS_KEY = "default_settings";
+
+class WidgetManifestData: public QSharedData
+{
+public:
+    explicit WidgetManifestData(const QString &source, const QJsonObject &json,
+                                const QDateTime &lastModified);
+    QString source;
+    QJsonObject json;
+    QDateTime lastModified;
+    QString name;
+    QString description;
+    QUrl widgetSource;
+    QVariantMap defaultSettings;
+};
+
+WidgetManifestData::WidgetManifestData(const QString &source, const QJsonObject &json,
+                                       const QDateTime &lastModified)
+    : source(source), json(json), lastModified(lastModified)
+{
+    // Everything is computed once, since manifests are never modified
+    name = json.value(NAME_KEY).toString();
+    description = json.value(DESCRIPTION_KEY).toString();
+    // Shared by all the instances of the widget, that only store overrides
+    defaultSettings = json.value(DEFAULT_SETTINGS_KEY).toObject().toVariantMap();
+    if (json.isEmpty()) {
+        return;
+    }
+
+    QDir dir (source);
+    QString file = dir.absoluteFilePath(WIDGET_FILE_NAME);
+    if (file.startsWith(":")) {
+        file = file.mid(1);
+        widgetSource = QUrl(QString("qrc:/%1").arg(file));
+    } else if (file.startsWith("qrc:")) {
+        file = file.mid(4);
+        widgetSource = QUrl(QString("qrc:/%1").arg(file));
+    } else {
+        widgetSource = QUrl::fromLocalFile(file);
+    }
+}
+
+WidgetManifest::WidgetManifest()
+{
+}
+
+WidgetManifest::WidgetManifest(const QString &source, const QJsonObject &json,
+                               const QDateTime &lastModified)
+    : d(new WidgetManifestData(source, json, lastModified))
+{
+}
+
+WidgetManifest::WidgetManifest(const WidgetManifest &other)
+    : d(other.d)
+{
+}
+
+WidgetManifest::~WidgetManifest()
+{
+}
+
+WidgetManifest & WidgetManifest::operator=(const WidgetManifest &other)
+{
+    d = other.d;
+    return *this;
+}
+
+WidgetManifest WidgetManifest::read(const QString &source)
+{
+    WIDGET_TRACE("WidgetManifest::read");
+    // Does not touch any shared state, so it can be used from worker threads
+    QDir subdir (source);
+
+    // Check widget description file inside dir
+    QString fileName = subdir.absoluteFilePath(WIDGET_DESCRIPTION_FILE);
+    QFileInfo fileInfo (fileName);
+    if (!fileInfo.exists()) {
+        return WidgetManifest(source, QJsonObject(), QDateTime());
+    }
+
+    QFile file (fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return WidgetManifest(source, QJsonObject(), fileInfo.lastModified());
+    }
+    QJsonParseError error;
+    QJsonDocument widgetDescriptionDocument = QJsonDocument::fromJson(file.readAll(), &error);
+    file.close();
+
+    if (error.error != QJsonParseError::NoError) {
+        qWarning() << "Error parsing widget description file:"
+                   << error.errorString().toLocal8Bit().data();
+        return WidgetManifest(source, QJsonObject(), fileInfo.lastModified());
+    }
+
+    return WidgetManifest(source, widgetDescriptionDocument.object(), fileInfo.lastModified());
+}
+
+bool WidgetManifest::isValid() const
+{
+    return d && !d->json.isEmpty();
+}
+
+QString WidgetManifest::source() const
+{
+    return d ? d->source : QString();
+}
+
+QString WidgetManifest::name() const
+{
+    return d ? d->name : QString();
+}
+
+QString WidgetManifest::description() const
+{
+    return d ? d->description : QString();
+}
+
+QUrl WidgetManifest::widgetSource() const
+{
+    return d ? d->widgetSource : QUrl();
+}
+
+QVariantMap WidgetManifest::defaultSettings() const
+{
+    return d ? d->defaultSettings : QVariantMap();
+}
+
+const QJsonObject & WidgetManifest::json() const
+{
+    static const QJsonObject empty;
+    return d ? d->json : empty;
+}
+
+QDateTime WidgetManifest::lastModified() const
+{
+    return d ? d->lastModified : QDateTime();
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetmanifestregistry.h"
+#include <QtCore/QHash>
+#include <QtCore/QReadWriteLock>
+
+struct WidgetManifestRegistryEntry
+{
+    WidgetManifestRegistryEntry();
+    WidgetManifest manifest;
+    int refCount;
+};
+
+WidgetManifestRegistryEntry::WidgetManifestRegistryEntry()
+    : refCount(0)
+{
+}
+
+class WidgetManifestRegistryPrivate
+{
+public:
+    explicit WidgetManifestRegistryPrivate(WidgetManifestRegistry *q);
+    mutable QReadWriteLock lock;
+    QHash<QString, WidgetManifestRegistryEntry> manifests;
+protected:
+    WidgetManifestRegistry * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetManifestRegistry)
+};
+
+WidgetManifestRegistryPrivate::WidgetManifestRegistryPrivate(WidgetManifestRegistry *q)
+    : q_ptr(q)
+{
+}
+
+WidgetManifestRegistry::WidgetManifestRegistry(QObject *parent)
+    : QObject(parent), d_ptr(new WidgetManifestRegistryPrivate(this))
+{
+}
+
+WidgetManifestRegistry::~WidgetManifestRegistry()
+{
+}
+
+WidgetManifest WidgetManifestRegistry::manifest(const QString &source)
+{
+    Q_D(WidgetManifestRegistry);
+    {
+        QReadLocker locker (&d->lock);
+        QHash<QString, WidgetManifestRegistryEntry>::const_iterator it = d->manifests.constFind(source);
+        if (it != d->manifests.constEnd()) {
+            return it.value().manifest;
+        }
+    }
+
+    // Unknown package: read it from disk once
+    WidgetManifest manifest = WidgetManifest::read(source);
+    if (manifest.isValid()) {
+        insert(manifest);
+    }
+    return manifest;
+}
+
+bool WidgetManifestRegistry::contains(const QString &source) const
+{
+    Q_D(const WidgetManifestRegistry);
+    QReadLocker locker (&d->lock);
+    return d->manifests.contains(source);
+}
+
+int WidgetManifestRegistry::count() const
+{
+    Q_D(const WidgetManifestRegistry);
+    QReadLocker locker (&d->lock);
+    return d->manifests.count();
+}
+
+// Adds or updates a manifest, without taking a reference. Manifests that
+// nobody retains, like the ones read on demand, stay until removed.
+void WidgetManifestRegistry::insert(const WidgetManifest &manifest)
+{
+    Q_D(WidgetManifestRegistry);
+    if (!manifest.isValid()) {
+        return;
+    }
+
+    QWriteLocker locker (&d->lock);
+    d->manifests[manifest.source()].manifest = manifest;
+}
+
+// The registry is shared by all the models of an engine, and several of
+// them can list the same package. A manifest that is retained is only
+// dropped when every model that retained it released it.
+void WidgetManifestRegistry::retain(const WidgetManifest &manifest)
+{
+    Q_D(WidgetManifestRegistry);
+    if (!manifest.isValid()) {
+        return;
+    }
+
+    QWriteLocker locker (&d->lock);
+    WidgetManifestRegistryEntry &entry = d->manifests[manifest.source()];
+    entry.manifest = manifest;
+    ++entry.refCount;
+}
+
+void WidgetManifestRegistry::release(const QString &source)
+{
+    Q_D(WidgetManifestRegistry);
+    QWriteLocker locker (&d->lock);
+    QHash<QString, WidgetManifestRegistryEntry>::iterator it = d->manifests.find(source);
+    if (it == d->manifests.end() || it.value().refCount <= 0) {
+        return;
+    }
+
+    if (--it.value().refCount == 0) {
+        d->manifests.erase(it);
+    }
+}
+
+void WidgetManifestRegistry::remove(const QString &source)
+{
+    Q_D(WidgetManifestRegistry);
+    QWriteLocker locker (&d->lock);
+    d->manifests.remove(source);
+}
+
+void WidgetManifestRegistry::clear()
+{
+    Q_D(WidgetManifestRegistry);
+    QWriteLocker locker (&d->lock);
+    d->manifests.clear();
+}
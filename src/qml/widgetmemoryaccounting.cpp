@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetmemoryaccounting.h"
+#include <QtCore/QBuffer>
+#include <QtCore/QDataStream>
+#include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QUrl>
+#include <QtQuick/QQuickItem>
+#include "widgetcontextinfo.h"
+#include "widgetfactory.h"
+
+#ifdef Q_OS_LINUX
+# include <unistd.h>
+#endif
+
+static const char *INSTANCE_COUNT_KEY = "instanceCount";
+static const char *OBJECT_COUNT_KEY = "objectCount";
+static const char *ITEM_COUNT_KEY = "itemCount";
+static const char *SETTINGS_SIZE_KEY = "settingsSize";
+static const char *DEFAULT_SETTINGS_SIZE_KEY = "defaultSettingsSize";
+static const char *PROPERTIES_SIZE_KEY = "propertiesSize";
+static const char *CREATION_MEMORY_KEY = "creationMemory";
+
+struct WidgetMemoryUsage
+{
+    WidgetMemoryUsage();
+    void add(const WidgetMemoryUsage &other);
+    QVariantMap toMap() const;
+    int instanceCount;
+    int objectCount;
+    int itemCount;
+    qint64 settingsSize;
+    qint64 propertiesSize;
+    qint64 creationMemory;
+    bool creationMeasured;
+};
+
+WidgetMemoryUsage::WidgetMemoryUsage()
+    : instanceCount(0), objectCount(0), itemCount(0), settingsSize(0), propertiesSize(0), creationMemory(0)
+    , creationMeasured(false)
+{
+}
+
+void WidgetMemoryUsage::add(const WidgetMemoryUsage &other)
+{
+    instanceCount += other.instanceCount;
+    objectCount += other.objectCount;
+    itemCount += other.itemCount;
+    settingsSize += other.settingsSize;
+    propertiesSize += other.propertiesSize;
+    // Memory might be released while a widget is created, so the growth
+    // can be negative
+    if (other.creationMeasured) {
+        creationMemory += other.creationMemory;
+        creationMeasured = true;
+    }
+}
+
+QVariantMap WidgetMemoryUsage::toMap() const
+{
+    QVariantMap map;
+    map.insert(INSTANCE_COUNT_KEY, instanceCount);
+    map.insert(OBJECT_COUNT_KEY, objectCount);
+    map.insert(ITEM_COUNT_KEY, itemCount);
+    map.insert(SETTINGS_SIZE_KEY, settingsSize);
+    map.insert(PROPERTIES_SIZE_KEY, propertiesSize);
+    if (creationMeasured) {
+        map.insert(CREATION_MEMORY_KEY, creationMemory);
+    }
+    return map;
+}
+
+class WidgetMemoryAccountingPrivate: public QObject
+{
+    Q_OBJECT
+public:
+    explicit WidgetMemoryAccountingPrivate(WidgetMemoryAccounting *q);
+    WidgetMemoryUsage usage(WidgetContextInfo *widgetContextInfo) const;
+    static void countObjects(QObject *object, WidgetMemoryUsage &usage);
+    static qint64 mapSize(const QVariantMap &map);
+    void contextInfoDestroyed(QObject *object);
+    WidgetFactory *factory;
+    QHash<WidgetContextInfo *, qint64> creationMemory;
+    bool enabled;
+protected:
+    WidgetMemoryAccounting * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetMemoryAccounting)
+};
+
+WidgetMemoryAccountingPrivate::WidgetMemoryAccountingPrivate(WidgetMemoryAccounting *q)
+    : QObject(), factory(0), enabled(false), q_ptr(q)
+{
+}
+
+// Everything is computed when asked for, from the live widgets, so that
+// the numbers follow what widgets create after they are loaded.
+WidgetMemoryUsage WidgetMemoryAccountingPrivate::usage(WidgetContextInfo *widgetContextInfo) const
+{
+    WidgetMemoryUsage usage;
+    usage.instanceCount = 1;
+    QHash<WidgetContextInfo *, qint64>::const_iterator i = creationMemory.constFind(widgetContextInfo);
+    if (i != creationMemory.constEnd()) {
+        usage.creationMemory = i.value();
+        usage.creationMeasured = true;
+    }
+    usage.settingsSize = mapSize(widgetContextInfo->overriddenSettings());
+    usage.propertiesSize = mapSize(widgetContextInfo->properties());
+    QObject *widget = factory->widget(widgetContextInfo);
+    if (widget) {
+        countObjects(widget, usage);
+    }
+    return usage;
+}
+
+void WidgetMemoryAccountingPrivate::countObjects(QObject *object, WidgetMemoryUsage &usage)
+{
+    ++usage.objectCount;
+    if (qobject_cast<QQuickItem *>(object)) {
+        ++usage.itemCount;
+    }
+
+    foreach (QObject *child, object->children()) {
+        countObjects(child, usage);
+    }
+}
+
+// The serialized size, that is close to the size of the data, without the
+// overhead of the containers
+qint64 WidgetMemoryAccountingPrivate::mapSize(const QVariantMap &map)
+{
+    if (map.isEmpty()) {
+        return 0;
+    }
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    QDataStream stream (&buffer);
+    stream << map;
+    return buffer.size();
+}
+
+void WidgetMemoryAccountingPrivate::contextInfoDestroyed(QObject *object)
+{
+    creationMemory.remove(static_cast<WidgetContextInfo *>(object));
+}
+
+WidgetMemoryAccounting::WidgetMemoryAccounting(WidgetFactory *factory, QObject *parent) :
+    QObject(parent), d_ptr(new WidgetMemoryAccountingPrivate(this))
+{
+    Q_D(WidgetMemoryAccounting);
+    d->factory = factory;
+}
+
+WidgetMemoryAccounting::~WidgetMemoryAccounting()
+{
+}
+
+bool WidgetMemoryAccounting::isEnabled() const
+{
+    Q_D(const WidgetMemoryAccounting);
+    return d->enabled;
+}
+
+void WidgetMemoryAccounting::setEnabled(bool enabled)
+{
+    Q_D(WidgetMemoryAccounting);
+    if (d->enabled != enabled) {
+        d->enabled = enabled;
+        emit enabledChanged();
+    }
+}
+
+// The JS heap size is not available from the public API. The growth of the
+// resident memory around the creation of a widget is used instead: it
+// includes the JS heap, but also any allocation made by other threads. The
+// factory does not incubate measured widgets over several frames, so that
+// their creations do not overlap. Only available on Linux.
+qint64 WidgetMemoryAccounting::residentMemory()
+{
+#ifdef Q_OS_LINUX
+    QFile file ("/proc/self/statm");
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+
+    QList<QByteArray> fields = file.readLine().split(' ');
+    if (fields.count() < 2) {
+        return -1;
+    }
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+void WidgetMemoryAccounting::recordCreation(WidgetContextInfo *widgetContextInfo, qint64 bytes)
+{
+    Q_D(WidgetMemoryAccounting);
+    if (!d->creationMemory.contains(widgetContextInfo)) {
+        connect(widgetContextInfo, &QObject::destroyed,
+                d, &WidgetMemoryAccountingPrivate::contextInfoDestroyed, Qt::UniqueConnection);
+    }
+    d->creationMemory.insert(widgetContextInfo, bytes);
+}
+
+QVariantMap WidgetMemoryAccounting::usage(WidgetContextInfo *widgetContextInfo) const
+{
+    Q_D(const WidgetMemoryAccounting);
+    if (!widgetContextInfo) {
+        return QVariantMap();
+    }
+
+    QVariantMap usage = d->usage(widgetContextInfo).toMap();
+    usage.remove(INSTANCE_COUNT_KEY);
+    return usage;
+}
+
+QStringList WidgetMemoryAccounting::sources() const
+{
+    Q_D(const WidgetMemoryAccounting);
+    QStringList sources;
+    foreach (WidgetContextInfo *widgetContextInfo, d->factory->widgetContextInfos()) {
+        QString source = d->factory->widgetSource(widgetContextInfo).toString();
+        if (!sources.contains(source)) {
+            sources.append(source);
+        }
+    }
+    sources.sort();
+    return sources;
+}
+
+// Default settings are shared by all the instances of a source, so they are
+// only counted once, separately.
+QVariantMap WidgetMemoryAccounting::sourceUsage(const QString &source) const
+{
+    Q_D(const WidgetMemoryAccounting);
+    WidgetMemoryUsage usage;
+    qint64 defaultSettingsSize = 0;
+    foreach (WidgetContextInfo *widgetContextInfo, d->factory->widgetContextInfos()) {
+        if (d->factory->widgetSource(widgetContextInfo).toString() == source) {
+            usage.add(d->usage(widgetContextInfo));
+            defaultSettingsSize = d->mapSize(widgetContextInfo->defaultSettings());
+        }
+    }
+
+    QVariantMap map = usage.toMap();
+    map.insert(DEFAULT_SETTINGS_SIZE_KEY, defaultSettingsSize);
+    return map;
+}
+
+void WidgetMemoryAccounting::dump() const
+{
+    foreach (const QString &source, sources()) {
+        QVariantMap usage = sourceUsage(source);
+        qDebug() << "Widget" << source.toLocal8Bit().data()
+                 << "instances" << usage.value(INSTANCE_COUNT_KEY).toInt()
+                 << "objects" << usage.value(OBJECT_COUNT_KEY).toInt()
+                 << "items" << usage.value(ITEM_COUNT_KEY).toInt()
+                 << "settings" << usage.value(SETTINGS_SIZE_KEY).toLongLong()
+                 << "default settings" << usage.value(DEFAULT_SETTINGS_SIZE_KEY).toLongLong()
+                 << "properties" << usage.value(PROPERTIES_SIZE_KEY).toLongLong()
+                 << "creation" << (usage.contains(CREATION_MEMORY_KEY)
+                                   ? QByteArray::number(usage.value(CREATION_MEMORY_KEY).toLongLong())
+                                   : QByteArray("unknown")).data();
+    }
+}
+
+#include "widgetmemoryaccounting.moc"
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetteardownscheduler.h"
+#include <QtCore/QBasicTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QPointer>
+#include <QtCore/QTimerEvent>
+#include <QtQuick/QQuickItem>
+
+static const int DEFAULT_BUDGET = 4;
+static const int TEARDOWN_INTERVAL = 16;
+
+class WidgetTeardownSchedulerPrivate: public QObject
+{
+    Q_OBJECT
+public:
+    explicit WidgetTeardownSchedulerPrivate(WidgetTeardownScheduler *q);
+    void processQueue();
+    QList<QPointer<QObject> > queue;
+    QBasicTimer timer;
+    int budget;
+protected:
+    void timerEvent(QTimerEvent *event);
+    WidgetTeardownScheduler * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetTeardownScheduler)
+};
+
+WidgetTeardownSchedulerPrivate::WidgetTeardownSchedulerPrivate(WidgetTeardownScheduler *q)
+    : QObject(), budget(DEFAULT_BUDGET), q_ptr(q)
+{
+}
+
+void WidgetTeardownSchedulerPrivate::processQueue()
+{
+    Q_Q(WidgetTeardownScheduler);
+    // At least one object is destroyed per frame, so that the queue always
+    // goes down, but a single tree is never split.
+    QElapsedTimer elapsed;
+    elapsed.start();
+    do {
+        delete queue.takeFirst().data();
+    } while (!queue.isEmpty() && elapsed.elapsed() < budget);
+
+    if (queue.isEmpty()) {
+        timer.stop();
+    }
+    emit q->pendingCountChanged();
+}
+
+void WidgetTeardownSchedulerPrivate::timerEvent(QTimerEvent *event)
+{
+    if (event->timerId() == timer.timerId()) {
+        processQueue();
+    }
+}
+
+WidgetTeardownScheduler::WidgetTeardownScheduler(QObject *parent) :
+    QObject(parent), d_ptr(new WidgetTeardownSchedulerPrivate(this))
+{
+}
+
+WidgetTeardownScheduler::~WidgetTeardownScheduler()
+{
+}
+
+int WidgetTeardownScheduler::budget() const
+{
+    Q_D(const WidgetTeardownScheduler);
+    return d->budget;
+}
+
+void WidgetTeardownScheduler::setBudget(int budget)
+{
+    Q_D(WidgetTeardownScheduler);
+    budget = qMax(1, budget);
+    if (d->budget != budget) {
+        d->budget = budget;
+        emit budgetChanged();
+    }
+}
+
+int WidgetTeardownScheduler::pendingCount() const
+{
+    Q_D(const WidgetTeardownScheduler);
+    return d->queue.count();
+}
+
+// Replaces deleteLater for widgets and their WidgetContextInfo. Objects are
+// detached right away, and destroyed a few at a time on the next frames, so
+// that removing many widgets, or a whole model, does not cause a hitch.
+void WidgetTeardownScheduler::schedule(QObject *object)
+{
+    Q_D(WidgetTeardownScheduler);
+    if (!object) {
+        return;
+    }
+
+    QQuickItem *item = qobject_cast<QQuickItem *>(object);
+    if (item) {
+        item->setVisible(false);
+        item->setParentItem(0);
+    }
+
+    // Owned by the scheduler, so that it is not destroyed with its parent
+    object->setParent(d);
+    d->queue.append(object);
+    if (!d->timer.isActive()) {
+        d->timer.start(TEARDOWN_INTERVAL, d);
+    }
+    emit pendingCountChanged();
+}
+
+void WidgetTeardownScheduler::flush()
+{
+    Q_D(WidgetTeardownScheduler);
+    d->timer.stop();
+    if (d->queue.isEmpty()) {
+        return;
+    }
+
+    while (!d->queue.isEmpty()) {
+        delete d->queue.takeFirst().data();
+    }
+    emit pendingCountChanged();
+}
+
+#include "widgetteardownscheduler.moc"
@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgettrace.h"
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+#include <QtCore/QSaveFile>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+// About 48 MB of events, a long session should not take all the memory
+static const int MAXIMUM_EVENT_COUNT = 1000000;
+
+struct WidgetTraceEvent
+{
+    const char *name;
+    char phase;
+    qint64 timestamp;
+    qint64 duration;
+    const void *id;
+    Qt::HANDLE thread;
+};
+
+struct WidgetTraceData
+{
+    WidgetTraceData();
+    void append(const char *name, char phase, qint64 timestamp, qint64 duration, const void *id);
+    QMutex mutex;
+    QElapsedTimer clock;
+    QString fileName;
+    QVector<WidgetTraceEvent> events;
+    int droppedCount;
+};
+
+WidgetTraceData::WidgetTraceData()
+    : droppedCount(0)
+{
+    clock.start();
+}
+
+void WidgetTraceData::append(const char *name, char phase, qint64 timestamp, qint64 duration, const void *id)
+{
+    QMutexLocker locker (&mutex);
+    if (events.count() >= MAXIMUM_EVENT_COUNT) {
+        ++droppedCount;
+        return;
+    }
+
+    WidgetTraceEvent event;
+    event.name = name;
+    event.phase = phase;
+    event.timestamp = timestamp;
+    event.duration = duration;
+    event.id = id;
+    event.thread = QThread::currentThreadId();
+    events.append(event);
+}
+
+Q_GLOBAL_STATIC(WidgetTraceData, traceData)
+
+QAtomicInt WidgetTrace::s_enabled;
+
+QString WidgetTrace::fileName()
+{
+    QMutexLocker locker (&traceData()->mutex);
+    return traceData()->fileName;
+}
+
+void WidgetTrace::start(const QString &fileName)
+{
+    stop();
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    WidgetTraceData *data = traceData();
+    {
+        QMutexLocker locker (&data->mutex);
+        data->fileName = fileName;
+        data->events.clear();
+    }
+    s_enabled.store(1);
+}
+
+bool WidgetTrace::stop()
+{
+    if (!s_enabled.fetchAndStoreOrdered(0)) {
+        return true;
+    }
+
+    // Events still being added are written, or dropped with the next trace
+    WidgetTraceData *data = traceData();
+    QString fileName;
+    QVector<WidgetTraceEvent> events;
+    int droppedCount;
+    {
+        QMutexLocker locker (&data->mutex);
+        fileName = data->fileName;
+        events.swap(data->events);
+        droppedCount = data->droppedCount;
+        data->fileName.clear();
+        data->droppedCount = 0;
+    }
+
+    if (droppedCount > 0) {
+        qWarning() << "Trace is full," << droppedCount << "events were dropped";
+    }
+
+    // Threads are numbered in order of appearance, to keep the ids readable
+    QList<Qt::HANDLE> threads;
+    qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    foreach (const WidgetTraceEvent &event, events) {
+        int thread = threads.indexOf(event.thread);
+        if (thread == -1) {
+            thread = threads.count();
+            threads.append(event.thread);
+        }
+
+        QJsonObject json;
+        json.insert("name", QString::fromLatin1(event.name));
+        json.insert("cat", QLatin1String("dashboard"));
+        json.insert("ph", QString(QLatin1Char(event.phase)));
+        json.insert("ts", double(event.timestamp));
+        json.insert("pid", double(pid));
+        json.insert("tid", thread);
+        if (event.phase == 'X') {
+            json.insert("dur", double(event.duration));
+        } else {
+            json.insert("id", QString::number(quintptr(event.id), 16));
+        }
+        traceEvents.append(json);
+    }
+
+    QJsonObject root;
+    root.insert("traceEvents", traceEvents);
+    root.insert("displayTimeUnit", QLatin1String("ms"));
+
+    QSaveFile file (fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write trace" << fileName << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+// In microseconds, as expected by the trace viewers
+qint64 WidgetTrace::timestamp()
+{
+    return traceData()->clock.nsecsElapsed() / 1000;
+}
+
+void WidgetTrace::complete(const char *name, qint64 timestamp, qint64 duration)
+{
+    // Tracing might have been stopped while the scope was running
+    if (isEnabled()) {
+        traceData()->append(name, 'X', timestamp, duration, 0);
+    }
+}
+
+void WidgetTrace::asyncBegin(const char *name, const void *id)
+{
+    WIDGET_TRACE_PROBE(async_begin, name);
+    if (isEnabled()) {
+        traceData()->append(name, 'b', timestamp(), 0, id);
+    }
+}
+
+void WidgetTrace::asyncEnd(const char *name, const void *id)
+{
+    WIDGET_TRACE_PROBE(async_end, name);
+    if (isEnabled()) {
+        traceData()->append(name, 'e', timestamp(), 0, id);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef WIDGETTRACE_H
+#define WIDGETTRACE_H
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QString>
+
+// Static tracepoints for perf and SystemTap, enabled with
+// qmake CONFIG+=dashboard_sdt. They cost a nop when not probed.
+#ifdef DASHBOARD_SDT
+# include <sys/sdt.h>
+# define WIDGET_TRACE_PROBE(probe, name) DTRACE_PROBE1(dashboard, probe, name)
+#else
+# define WIDGET_TRACE_PROBE(probe, name)
+#endif
+
+// Trace events are collected in memory while a trace file is set, and
+// written as Chrome trace events (chrome://tracing) when tracing stops.
+// Names are not copied, so they must be string literals. Events can be
+// emitted from any thread; when tracing is disabled, they cost a single
+// atomic load.
+class WidgetTrace
+{
+public:
+    static inline bool isEnabled()
+    {
+        return s_enabled.load() != 0;
+    }
+    static QString fileName();
+    static void start(const QString &fileName);
+    static bool stop();
+    static qint64 timestamp();
+    static void complete(const char *name, qint64 timestamp, qint64 duration);
+    static void asyncBegin(const char *name, const void *id);
+    static void asyncEnd(const char *name, const void *id);
+private:
+    static QAtomicInt s_enabled;
+};
+
+class WidgetTraceScope
+{
+public:
+    inline explicit WidgetTraceScope(const char *name)
+        : m_name(name), m_timestamp(WidgetTrace::isEnabled() ? WidgetTrace::timestamp() : -1)
+    {
+        WIDGET_TRACE_PROBE(begin, m_name);
+    }
+    inline ~WidgetTraceScope()
+    {
+        WIDGET_TRACE_PROBE(end, m_name);
+        if (m_timestamp >= 0) {
+            WidgetTrace::complete(m_name, m_timestamp, WidgetTrace::timestamp() - m_timestamp);
+        }
+    }
+private:
+    Q_DISABLE_COPY(WidgetTraceScope)
+    const char *m_name;
+    qint64 m_timestamp;
+};
+
+#define WIDGET_TRACE(name) WidgetTraceScope widgetTraceScope (name)
+
+#endif // WIDGETTRACE_H
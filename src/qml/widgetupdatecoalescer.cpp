@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#include "widgetupdatecoalescer.h"
+#include <QtCore/QBasicTimer>
+#include <QtCore/QHash>
+#include <QtCore/QTimerEvent>
+#include "widgetcontextinfo.h"
+
+// One frame at 60 Hz
+static const int DEFAULT_INTERVAL = 16;
+
+class WidgetUpdateCoalescerPrivate: public QObject
+{
+    Q_OBJECT
+public:
+    explicit WidgetUpdateCoalescerPrivate(WidgetUpdateCoalescer *q);
+    void schedule();
+    void contextInfoDestroyed(QObject *object);
+    QHash<WidgetContextInfo *, QVariantMap> pending;
+    QBasicTimer timer;
+    int interval;
+    int postedCount;
+    int mergedCount;
+    int droppedCount;
+    int flushedCount;
+protected:
+    void timerEvent(QTimerEvent *event);
+    WidgetUpdateCoalescer * const q_ptr;
+private:
+    Q_DECLARE_PUBLIC(WidgetUpdateCoalescer)
+};
+
+WidgetUpdateCoalescerPrivate::WidgetUpdateCoalescerPrivate(WidgetUpdateCoalescer *q)
+    : QObject(), interval(DEFAULT_INTERVAL), postedCount(0), mergedCount(0), droppedCount(0)
+    , flushedCount(0), q_ptr(q)
+{
+}
+
+void WidgetUpdateCoalescerPrivate::schedule()
+{
+    // Not restarted: updates are flushed at a steady rate while they come
+    if (!timer.isActive()) {
+        timer.start(interval, this);
+    }
+}
+
+void WidgetUpdateCoalescerPrivate::contextInfoDestroyed(QObject *object)
+{
+    // Only used as a key, the object is already gone
+    QHash<WidgetContextInfo *, QVariantMap>::iterator i = pending.find(static_cast<WidgetContextInfo *>(object));
+    if (i != pending.end()) {
+        droppedCount += i.value().count();
+        pending.erase(i);
+    }
+}
+
+void WidgetUpdateCoalescerPrivate::timerEvent(QTimerEvent *event)
+{
+    Q_Q(WidgetUpdateCoalescer);
+    if (event->timerId() == timer.timerId()) {
+        q->flush();
+    }
+}
+
+WidgetUpdateCoalescer::WidgetUpdateCoalescer(QObject *parent) :
+    QObject(parent), d_ptr(new WidgetUpdateCoalescerPrivate(this))
+{
+}
+
+WidgetUpdateCoalescer::~WidgetUpdateCoalescer()
+{
+}
+
+int WidgetUpdateCoalescer::interval() const
+{
+    Q_D(const WidgetUpdateCoalescer);
+    return d->interval;
+}
+
+void WidgetUpdateCoalescer::setInterval(int interval)
+{
+    Q_D(WidgetUpdateCoalescer);
+    interval = qMax(0, interval);
+    if (d->interval != interval) {
+        d->interval = interval;
+        if (d->timer.isActive()) {
+            d->timer.start(interval, d);
+        }
+        emit intervalChanged();
+    }
+}
+
+int WidgetUpdateCoalescer::pendingCount() const
+{
+    Q_D(const WidgetUpdateCoalescer);
+    return d->pending.count();
+}
+
+int WidgetUpdateCoalescer::postedCount() const
+{
+    Q_D(const WidgetUpdateCoalescer);
+    return d->postedCount;
+}
+
+int WidgetUpdateCoalescer::mergedCount() const
+{
+    Q_D(const WidgetUpdateCoalescer);
+    return d->mergedCount;
+}
+
+int WidgetUpdateCoalescer::droppedCount() const
+{
+    Q_D(const WidgetUpdateCoalescer);
+    return d->droppedCount;
+}
+
+int WidgetUpdateCoalescer::flushedCount() const
+{
+    Q_D(const WidgetUpdateCoalescer);
+    return d->flushedCount;
+}
+
+void WidgetUpdateCoalescer::post(WidgetContextInfo *widgetContextInfo, const QString &key,
+                                 const QVariant &value)
+{
+    Q_D(WidgetUpdateCoalescer);
+    if (!widgetContextInfo) {
+        return;
+    }
+
+    ++d->postedCount;
+    QHash<WidgetContextInfo *, QVariantMap>::iterator i = d->pending.find(widgetContextInfo);
+    if (i == d->pending.end()) {
+        connect(widgetContextInfo, &QObject::destroyed, d, &WidgetUpdateCoalescerPrivate::contextInfoDestroyed,
+                Qt::UniqueConnection);
+        i = d->pending.insert(widgetContextInfo, QVariantMap());
+    }
+
+    // A value that is replaced before the flush is never seen by bindings
+    if (i.value().contains(key)) {
+        ++d->mergedCount;
+    }
+    i.value().insert(key, value);
+
+    // Statistics are notified once when a batch starts, and once when it is
+    // flushed, not for every posted value
+    bool started = !d->timer.isActive();
+    d->schedule();
+    if (started) {
+        emit statisticsChanged();
+    }
+}
+
+void WidgetUpdateCoalescer::postProperties(WidgetContextInfo *widgetContextInfo, const QVariantMap &properties)
+{
+    QVariantMap::const_iterator i;
+    for (i = properties.constBegin(); i != properties.constEnd(); ++i) {
+        post(widgetContextInfo, i.key(), i.value());
+    }
+}
+
+void WidgetUpdateCoalescer::flush()
+{
+    Q_D(WidgetUpdateCoalescer);
+    d->timer.stop();
+    if (d->pending.isEmpty()) {
+        return;
+    }
+
+    // Taken first, updates posted from bindings go to the next flush
+    QHash<WidgetContextInfo *, QVariantMap> pending = d->pending;
+    d->pending.clear();
+
+    QHash<WidgetContextInfo *, QVariantMap>::const_iterator i;
+    for (i = pending.constBegin(); i != pending.constEnd(); ++i) {
+        WidgetContextInfo *widgetContextInfo = i.key();
+        disconnect(widgetContextInfo, &QObject::destroyed,
+                   d, &WidgetUpdateCoalescerPrivate::contextInfoDestroyed);
+
+        // One change notification per widget, whatever the number of keys
+        QVariantMap properties = widgetContextInfo->properties();
+        bool changed = false;
+        QVariantMap::const_iterator j;
+        for (j = i.value().constBegin(); j != i.value().constEnd(); ++j) {
+            if (properties.contains(j.key()) && properties.value(j.key()) == j.value()) {
+                ++d->droppedCount;
+            } else {
+                properties.insert(j.key(), j.value());
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            widgetContextInfo->setProperties(properties);
+            ++d->flushedCount;
+        }
+    }
+    emit statisticsChanged();
+}
+
+void WidgetUpdateCoalescer::resetStatistics()
+{
+    Q_D(WidgetUpdateCoalescer);
+    d->postedCount = 0;
+    d->mergedCount = 0;
+    d->droppedCount = 0;
+    d->flushedCount = 0;
+    emit statisticsChanged();
+}
+
+#include "widgetupdatecoalescer.moc"
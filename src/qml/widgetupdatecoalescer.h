@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2014 Lucien XU <sfietkonstantin@free.fr>
+ *
+ * You may use this file under the terms of the BSD license as follows:
+ *
+ * "Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in
+ *     the documentation and/or other materials provided with the
+ *     distribution.
+ *   * The names of its contributors may not be used to endorse or promote
+ *     products derived from this software without specific prior written
+ *     permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
+ */
+
+#ifndef WIDGETUPDATECOALESCER_H
+#define WIDGETUPDATECOALESCER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QVariantMap>
+
+class WidgetContextInfo;
+class WidgetUpdateCoalescerPrivate;
+class WidgetUpdateCoalescer : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    Q_PROPERTY(int pendingCount READ pendingCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int postedCount READ postedCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int mergedCount READ mergedCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int droppedCount READ droppedCount NOTIFY statisticsChanged)
+    Q_PROPERTY(int flushedCount READ flushedCount NOTIFY statisticsChanged)
+public:
+    explicit WidgetUpdateCoalescer(QObject *parent = 0);
+    virtual ~WidgetUpdateCoalescer();
+    int interval() const;
+    void setInterval(int interval);
+    int pendingCount() const;
+    int postedCount() const;
+    int mergedCount() const;
+    int droppedCount() const;
+    int flushedCount() const;
+public Q_SLOTS:
+    void post(WidgetContextInfo *widgetContextInfo, const QString &key, const QVariant &value);
+    void postProperties(WidgetContextInfo *widgetContextInfo, const QVariantMap &properties);
+    void flush();
+    void resetStatistics();
+Q_SIGNALS:
+    void intervalChanged();
+    void statisticsChanged();
+protected:
+    QScopedPointer<WidgetUpdateCoalescerPrivate> d_ptr;
+private:
+    Q_DECLARE_PRIVATE(WidgetUpdateCoalescer)
+};
+
+#endif // WIDGETUPDATECOALESCER_H
@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS = qml tests
+SUBDIRS = qml indexer tests
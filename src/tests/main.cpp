@@ -29,12 +29,22 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE."
  */
 
+#include <QtCore/QStandardPaths>
 #include <QtGui/QGuiApplication>
 #include <QtQml/qqml.h>
 #include <QtQml/QQmlContext>
 #include <QtQuick/QQuickView>
+#include "../qml/dashboardservice.h"
+#include "../qml/widgetcomponentcache.h"
 #include "../qml/widgetcontextinfo.h"
+#include "../qml/widgetcreationstatistics.h"
+#include "../qml/widgetinputcontroller.h"
+#include "../qml/widgetlayout.h"
+#include "../qml/widgetlayoutindex.h"
 #include "../qml/widgetlistmodel.h"
+#include "../qml/widgetmemoryaccounting.h"
+#include "../qml/widgetteardownscheduler.h"
+#include "../qml/widgetupdatecoalescer.h"
 #include "../qml/installedwidgetlistmodel.h"
 
 int main(int argc, char **argv)
@@ -43,7 +53,24 @@ int main(int argc, char **argv)
     qmlRegisterUncreatableType<WidgetContextInfo>("org.SfietKonstantin.widgets", 2, 0, "Widget", "Cannot be created");
     qmlRegisterType<InstalledWidgetListModel>("org.SfietKonstantin.widgets", 2, 0, "InstalledWidgetListModel");
     qmlRegisterType<WidgetListModel>("org.SfietKonstantin.widgets", 2, 0, "WidgetListModel");
+    qmlRegisterType<WidgetInputController>("org.SfietKonstantin.widgets", 2, 0, "WidgetInputController");
+    qmlRegisterType<WidgetLayout>("org.SfietKonstantin.widgets", 2, 0, "WidgetLayout");
+    qmlRegisterType<WidgetLayoutIndex>("org.SfietKonstantin.widgets", 2, 0, "WidgetLayoutIndex");
+    qmlRegisterUncreatableType<WidgetComponentCache>("org.SfietKonstantin.widgets", 2, 0, "WidgetComponentCache",
+                                                     "Cannot be created");
+    qmlRegisterUncreatableType<WidgetCreationStatistics>("org.SfietKonstantin.widgets", 2, 0, "WidgetCreationStatistics",
+                                                         "Cannot be created");
+    qmlRegisterUncreatableType<WidgetMemoryAccounting>("org.SfietKonstantin.widgets", 2, 0, "WidgetMemoryAccounting",
+                                                       "Cannot be created");
+    qmlRegisterUncreatableType<WidgetTeardownScheduler>("org.SfietKonstantin.widgets", 2, 0, "WidgetTeardownScheduler",
+                                                        "Cannot be created");
+    qmlRegisterUncreatableType<WidgetUpdateCoalescer>("org.SfietKonstantin.widgets", 2, 0, "WidgetUpdateCoalescer",
+                                                      "Cannot be created");
+    qmlRegisterSingletonType<DashboardService>("org.SfietKonstantin.widgets", 2, 0, "Dashboard",
+                                               DashboardService::singletonProvider);
     QQuickView view;
+    QString dataPath = QStandardPaths::writableLocation(QStandardPaths::DataLocation);
+    view.rootContext()->setContextProperty("dashboardStorageFile", dataPath + "/dashboard.layout");
     view.setResizeMode(QQuickView::SizeRootObjectToView);
     view.setSource(QUrl("qrc:/main.qml"));
     view.show();
@@ -6,147 +6,130 @@ Rectangle {
     width: 600
     height: 600
 
-    Item {
-        id: flowContainer
-        height: flow.height
+    Flickable {
+        id: flickable
+        anchors.top: parent.top; anchors.bottom: parent.bottom
         anchors.left: parent.left; anchors.right: widgetPanel.left
-        property Item movingItem
-
-        Timer {
-            id: moveTimer
-            property int moveCurrentIndex: -1
-            property int moveTargetIndex: -1
-            interval: 150
-            repeat: false
-            onTriggered: {
-                if (moveTargetIndex != -1) {
-                    widgetModel.move(moveTimer.moveCurrentIndex, moveTimer.moveTargetIndex)
+        contentHeight: flowContainer.height
+        interactive: flowContainer.movingItem == null
+
+        Item {
+            id: flowContainer
+            height: flow.height
+            width: flickable.width
+            property Item movingItem
+
+            Timer {
+                id: moveTimer
+                property int moveCurrentIndex: -1
+                property int moveTargetIndex: -1
+                interval: 150
+                repeat: false
+                onTriggered: {
+                    if (moveTargetIndex != -1) {
+                        widgetModel.move(moveTimer.moveCurrentIndex, moveTimer.moveTargetIndex)
+                    }
                 }
             }
-        }
 
-        Flow {
-            id: flow
-            anchors.left: parent.left; anchors.right: parent.right
-            move: Transition {
-                NumberAnimation {
-                    properties: "x,y"
-                    easing.type: Easing.InOutQuad
-                }
+            WidgetLayoutIndex {
+                id: layoutIndex
+                layout: flow
+                viewport: flickable
+                viewportMargin: 200
             }
 
-            Repeater {
-                model: WidgetListModel {
-                    id: widgetModel
-                }
+            WidgetListModel {
+                id: widgetModel
+                asynchronous: true
+                storageFile: dashboardStorageFile
+            }
 
-                delegate: WidgetContainer {
-                    id: widgetContainer
-                    widgetListModel: widgetModel
-                    function getWidth() {
-                        switch (model.contextInfo.size) {
-                        case Widget.Small:
-                            return flow.width / 4
-                        case Widget.Medium:
-                            return flow.width / 2
-                        case Widget.Large:
-                            return flow.width
+            WidgetLayout {
+                id: flow
+                anchors.left: parent.left; anchors.right: parent.right
+                model: widgetModel
+
+                Repeater {
+                    model: widgetModel
+
+                    delegate: WidgetContainer {
+                        id: widgetContainer
+                        widgetListModel: widgetModel
+                        index: model.index
+                        interactive: false
+                        virtualized: true
+                        contextInfo: model.contextInfo
+                        placeholder: Rectangle {
+                            color: "lightgray"
                         }
-                    }
-
-                    width: getWidth()
-                    minimumHeight: 200
-//                    height: 100
-                    moveParent: flowContainer
-                    onClicked: widgetModel.remove(model.index)
-                    onPressAndHold: {
-                        switch (model.contextInfo.size) {
-                        case Widget.Small:
-                            widgetModel.setSize(model.index, Widget.Medium)
-                            break
-                        case Widget.Medium:
-                            widgetModel.setSize(model.index, Widget.Large)
-                            break
-                        case Widget.Large:
-                            widgetModel.setSize(model.index, Widget.Small)
-                            break
+                        minimumHeight: 200
+//                        height: 100
+                        moveParent: flowContainer
+                        Behavior on x {
+                            NumberAnimation { easing.type: Easing.InOutQuad }
                         }
-                    }
-                    onMoveStarted: {
-                        flowContainer.movingItem = widgetContainer
-                    }
-                    onMoveFinished: {
-                        moveTimer.moveTargetIndex = -1
-                        moveTimer.moveCurrentIndex = -1
-                        moveTimer.stop()
-                        flowContainer.movingItem = null
-                    }
-                    onMoved: {
-                        if (flowContainer.movingItem === widgetContainer) {
-                            // Build the list of childrens
-                            var children = []
-                            for (var i = 0; i < flow.children.length; i++) {
-                                var child = flow.children[i]
-                                if (child.width > 0 && child.height > 0) {
-                                    children.push(child)
-                                }
-                            }
-
-                            children.sort(
-                                function(a, b) {
-                                    return (a.y * flowContainer.width + a.x
-                                            - (b.y * flowContainer.width + b.x))
-                                })
-
-
-                            // We seek for the best index candidate
-                            // First we find the row (ie starting index that fit the y)
-                            var previousY = 0
-                            var nextY = -1
-                            var firstIndex = 0
-                            var lastIndex = children.length
-                            for (i = 0; i < children.length; i++) {
-                                var currentY = children[i].y
-                                if (currentY > previousY && currentY <= y) {
-                                    firstIndex = i
-                                    previousY = currentY
-                                }
-
-                                if (currentY > y && i < lastIndex) {
-                                    lastIndex = i
-                                    nextY = currentY
-                                }
-                            }
-
-                            var finalIndex = lastIndex
-                            // Now we scan the x position to check after which index it fits
-                            for (i = firstIndex; i < lastIndex; i++) {
-                                var width = children[i].width
-                                var beginX = children[i].x
-                                var midX = beginX + width / 2
-                                var endX = beginX + width
-
-                                if (y < nextY) {
-                                    // If we are on the left: bias toward previous index
-                                    // else, bias toward next
-                                    if (x < endX) {
-                                        if (x < midX) {
-                                            finalIndex = i
-                                        } else {
-                                            finalIndex = i + 1
-                                        }
-                                        break
-                                    }
-                                }
+                        Behavior on y {
+                            NumberAnimation { easing.type: Easing.InOutQuad }
+                        }
+                        Component.onCompleted: {
+                            flow.addItem(widgetContainer, model.contextInfo)
+                            layoutIndex.addItem(widgetContainer)
+                        }
+                        Component.onDestruction: {
+                            flow.removeItem(widgetContainer)
+                            layoutIndex.removeItem(widgetContainer)
+                        }
+                        onMoveStarted: {
+                            flowContainer.movingItem = widgetContainer
+                        }
+                        onMoveFinished: {
+                            moveTimer.moveTargetIndex = -1
+                            moveTimer.moveCurrentIndex = -1
+                            moveTimer.stop()
+                            flowContainer.movingItem = null
+                        }
+                        onMoved: {
+                            if (flowContainer.movingItem === widgetContainer) {
+                                moveTimer.moveCurrentIndex = model.index
+                                // The index is in the coordinates of the layout
+                                var position = widgetContainer.mapToItem(flow, x, y)
+                                moveTimer.moveTargetIndex = layoutIndex.insertionIndex(position.x, position.y)
+                                moveTimer.restart()
                             }
-
-                            moveTimer.moveCurrentIndex = model.index
-                            moveTimer.moveTargetIndex = finalIndex
-                            moveTimer.restart()
                         }
                     }
                 }
             }
+
+            WidgetInputController {
+                id: inputController
+                anchors.fill: flow
+                layout: flow
+                onClicked: widgetModel.remove(item.index)
+                onPressAndHold: {
+                    switch (item.contextInfo.size) {
+                    case Widget.Small:
+                        widgetModel.setSize(item.index, Widget.Medium)
+                        break
+                    case Widget.Medium:
+                        widgetModel.setSize(item.index, Widget.Large)
+                        break
+                    case Widget.Large:
+                        widgetModel.setSize(item.index, Widget.Small)
+                        break
+                    }
+                }
+                onDragStarted: {
+                    var position = item.mapFromItem(inputController, x, y)
+                    item.startMove(position.x, position.y)
+                }
+                onDragMoved: {
+                    var position = item.mapFromItem(inputController, x, y)
+                    item.moveTo(position.x, position.y)
+                }
+                onDragFinished: item.finishMove()
+            }
         }
     }
 
@@ -161,6 +144,12 @@ Rectangle {
             searchPaths: ":/"
         }
 
+        Text {
+            anchors.centerIn: parent
+            visible: installed.loading
+            text: "Loading..."
+        }
+
         ListView {
             id: installedView
             anchors.fill: parent
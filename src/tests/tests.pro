@@ -2,19 +2,47 @@ TEMPLATE = app
 
 TARGET = dashboard-test
 
-QT = core gui qml quick
+QT = core gui qml quick concurrent
+
+dashboard_sdt: DEFINES += DASHBOARD_SDT
 
 HEADERS += \
+    ../qml/dashboardservice.h \
+    ../qml/widgetcomponentcache.h \
     ../qml/widgetcontextinfo.h \
+    ../qml/widgetcreationstatistics.h \
     ../qml/widgetfactory.h \
+    ../qml/widgetindex.h \
+    ../qml/widgetinputcontroller.h \
+    ../qml/widgetlayout.h \
+    ../qml/widgetlayoutindex.h \
     ../qml/widgetlistmodel.h \
+    ../qml/widgetmanifest.h \
+    ../qml/widgetmanifestregistry.h \
+    ../qml/widgetmemoryaccounting.h \
+    ../qml/widgetteardownscheduler.h \
+    ../qml/widgettrace.h \
+    ../qml/widgetupdatecoalescer.h \
     ../qml/installedwidgetlistmodel.h
 
 SOURCES += \
     main.cpp \
+    ../qml/dashboardservice.cpp \
+    ../qml/widgetcomponentcache.cpp \
     ../qml/widgetcontextinfo.cpp \
+    ../qml/widgetcreationstatistics.cpp \
     ../qml/widgetfactory.cpp \
+    ../qml/widgetindex.cpp \
+    ../qml/widgetinputcontroller.cpp \
+    ../qml/widgetlayout.cpp \
+    ../qml/widgetlayoutindex.cpp \
     ../qml/widgetlistmodel.cpp \
+    ../qml/widgetmanifest.cpp \
+    ../qml/widgetmanifestregistry.cpp \
+    ../qml/widgetmemoryaccounting.cpp \
+    ../qml/widgetteardownscheduler.cpp \
+    ../qml/widgettrace.cpp \
+    ../qml/widgetupdatecoalescer.cpp \
     ../qml/installedwidgetlistmodel.cpp
 
 RESOURCES += \